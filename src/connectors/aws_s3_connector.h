@@ -212,7 +212,7 @@ public:
 
     void do_send(MessageWrapper & msg_w)override{
         std::string file_name = derive_object_name(msg_w);
-        std::string file_content = msg_w.msg().get_raw();
+        std::string file_content(msg_w.view().get_raw());
 
         Aws::S3::Model::PutObjectRequest request;
         request.SetBucket(bucket_name_);
@@ -251,7 +251,7 @@ public:
     }
 
     void do_send(MessageWrapper & msg_w)override{
-        std::string payload = msg_w.msg().get_raw();
+        std::string payload(msg_w.view().get_raw());
         std::string content_type = "text/plain; charset=utf-8";
 
         // Set CURL options
@@ -28,9 +28,12 @@ IN THE SOFTWARE.
 
 
 #include "nlohmann/json.hpp"
+#include <chrono>
 #include <iostream>
+#include <span>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "m2e_exceptions.h"
 #include "m2e_message/message_wrapper.h"
@@ -99,16 +102,24 @@ public:
         do_stop();
     }
 
-    std::shared_ptr<Message> receive(){
+    std::shared_ptr<Message const> receive(){
         using namespace std::chrono;
-        time_t now = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
-        if(stat_.last_in + polling_period_ > now){
-            std::this_thread::sleep_for(seconds(stat_.last_in + polling_period_ - now));
-        }
-        Message msg = do_receive();
+        wait_polling_period();
+        auto msg_ptr = do_receive_shared();
         ++stat_.count_in;
         stat_.last_in = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
-        return std::make_shared<Message>(std::move(msg));
+        return msg_ptr;
+    }
+
+    // Blocks until at least one message is received, then returns up to `max_n`
+    // messages which arrive within `max_wait`
+    std::vector<std::shared_ptr<Message const>> receive_batch(size_t max_n, std::chrono::milliseconds max_wait){
+        using namespace std::chrono;
+        wait_polling_period();
+        auto batch = do_receive_batch(max_n > 0 ? max_n : 1, max_wait);
+        stat_.count_in += batch.size();
+        stat_.last_in = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+        return batch;
     }
 
     void send(MessageWrapper & msg_w){
@@ -119,6 +130,16 @@ public:
         stat_.last_out = duration_cast<seconds>(now).count();
     }
 
+    // Throws if the batch could not be sent, some of the messages may have been sent then
+    void send_batch(std::span<MessageWrapper> batch){
+        using namespace std::chrono;
+        if(batch.empty()) return;
+        do_send_batch(batch);
+        stat_.count_out += batch.size();
+        auto now = system_clock::now().time_since_epoch();
+        stat_.last_out = duration_cast<seconds>(now).count();
+    }
+
     ConnectorStat get_statistics(){
         return stat_;
     }
@@ -155,6 +176,14 @@ public:
     }
 */
 private:
+    void wait_polling_period(){
+        using namespace std::chrono;
+        time_t now = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+        if(stat_.last_in + polling_period_ > now){
+            std::this_thread::sleep_for(seconds(stat_.last_in + polling_period_ - now));
+        }
+    }
+
     virtual Message const do_receive(){
         throw std::logic_error("do_receive not implemented!");
     }
@@ -163,6 +192,26 @@ private:
         throw std::logic_error("do_receive not implemented!");
     }
 
+    // Connectors which already keep received messages in shared pointers override
+    // this to hand them over without copying
+    virtual std::shared_ptr<Message const> do_receive_shared(){
+        Message msg = do_receive();
+        return std::make_shared<Message const>(std::move(msg));
+    }
+
+    // do_receive() blocks until a message arrives, so calling it again could hold
+    // the received message for ever. Connectors which can check for more messages
+    // without blocking override this.
+    virtual std::vector<std::shared_ptr<Message const>> do_receive_batch(size_t max_n, std::chrono::milliseconds max_wait){
+        return {do_receive_shared()};
+    }
+
+    virtual void do_send_batch(std::span<MessageWrapper> batch){
+        for(auto & msg_w : batch){
+            do_send(msg_w);
+        }
+    }
+
     virtual void do_connect(){}
 
     virtual void do_disconnect(){}
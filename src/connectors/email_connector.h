@@ -244,8 +244,8 @@ public:
 
     void do_send( MessageWrapper & msg_w )override
     {
-        std::string subject = msg_w.msg().get_topic();
-        std::string body = msg_w.msg().get_raw();
+        std::string subject = msg_w.view().get_topic();
+        std::string body(msg_w.view().get_raw());
 
         send_email(subject, body);
     }
@@ -202,7 +202,7 @@ public:
         while(regex_search(pos, file_name.cend(), match, pattern)){
             std::string ve = match[1].str();
             if(ve == "topic"){
-                std::string vvalue = msg_w.msg().get_topic();
+                std::string vvalue = msg_w.view().get_topic();
 
                 vvalue.erase(remove(vvalue.begin(), vvalue.end(), '/'), vvalue.end());
 
@@ -234,7 +234,7 @@ public:
 
     void do_send(MessageWrapper & msg_w)override{
         std::string file_name = derive_object_name(msg_w);
-        std::string file_content = msg_w.msg().get_raw();
+        std::string file_content(msg_w.view().get_raw());
 
         gcloud::storage::ObjectWriteStream stream = client_.WriteObject(bucket_name_, file_name);
         stream << file_content;
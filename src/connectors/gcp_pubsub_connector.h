@@ -33,7 +33,6 @@ IN THE SOFTWARE.
 #include <utility>
 #include <stdexcept>
 #include <cstdlib>
-#include <regex>
 #include <fstream>
 #include <iterator>
 
@@ -110,7 +109,7 @@ private:
     gcloud::pubsub_admin::TopicAdminClient *topic_admin_;
     gcloud::pubsub_admin::SubscriptionAdminClient *sub_admin_;
 
-    map<string, std::pair<bool,string>> attributes_;
+    map<string, CompiledTemplate> attributes_;
 
 public:
     PubSubConnector(std::string pipeid, ConnectorMode mode, json const & json_descr):
@@ -165,14 +164,9 @@ public:
         }
 
         if(json_descr.contains("attributes")){
-            std::smatch match;
-            std::regex pattern("\\{\\{(.*?)\\}\\}");
-
             json const & attributes = json_descr["attributes"];
             for(auto it = attributes.begin(); it != attributes.end(); ++it){
-                string v = (*it).get<string>();
-                bool is_dynamic = std::regex_search(v.cbegin(), v.cend(), match, pattern);
-                attributes_[it.key()] = std::pair(is_dynamic, v);
+                attributes_[it.key()] = CompiledTemplate((*it).get<string>());
             }
         }
     }
@@ -263,13 +257,13 @@ public:
 
     void do_send(MessageWrapper & msg_w)override{
         try{
-            auto mb = pubsub::MessageBuilder{}.SetData(msg_w.msg().get_raw());
+            auto mb = pubsub::MessageBuilder{}.SetData(std::string(msg_w.view().get_raw()));
             for(auto const & attribute : attributes_){
-                if(attribute.second.first){
-                    string av = derive_attribute(msg_w, attribute.second.second);
+                if(attribute.second.is_dynamic()){
+                    string av = derive_attribute(msg_w, attribute.second);
                     mb.InsertAttribute(attribute.first, av);
                 }else{
-                    mb.InsertAttribute(attribute.first, attribute.second.second);
+                    mb.InsertAttribute(attribute.first, attribute.second.source());
                 }
             }
 
@@ -281,7 +275,35 @@ public:
         }
     }
 
-    string derive_attribute(MessageWrapper & msg_w, string const & atemplate){
+    // Publishes all messages before waiting for the first result, so the client
+    // library may pack them into fewer requests
+    void do_send_batch(std::span<MessageWrapper> batch)override{
+        try{
+            std::vector<gcloud::future<gcloud::StatusOr<std::string>>> results;
+            results.reserve(batch.size());
+            for(auto & msg_w : batch){
+                auto mb = pubsub::MessageBuilder{}.SetData(std::string(msg_w.view().get_raw()));
+                for(auto const & attribute : attributes_){
+                    if(attribute.second.is_dynamic()){
+                        string av = derive_attribute(msg_w, attribute.second);
+                        mb.InsertAttribute(attribute.first, av);
+                    }else{
+                        mb.InsertAttribute(attribute.first, attribute.second.source());
+                    }
+                }
+                results.push_back(publisher_ptr_->Publish(std::move(mb).Build()));
+            }
+            for(auto & result : results){
+                auto id = result.get();
+                if(!id) throw std::move(id).status();
+            }
+        }
+        catch (google::cloud::Status const& status) {
+            throw std::runtime_error("Unable to publish to gcp pub/sub");
+        }
+    }
+
+    string derive_attribute(MessageWrapper & msg_w, CompiledTemplate const & atemplate){
         auto se = SubsEngine(msg_w);
         return std::get<string>(se.substitute(atemplate));
     }
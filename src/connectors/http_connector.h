@@ -36,23 +36,7 @@ IN THE SOFTWARE.
 
 #include "connector.h"
 #include "database/authbundle.h"
-
-inline std::string base64_encode(const std::string& input) {
-    static const char encode_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    std::string encoded;
-    int val = 0, valb = -6;
-    for (unsigned char c : input) {
-        val = (val << 8) + c;
-        valb += 8;
-        while (valb >= 0) {
-            encoded.push_back(encode_table[(val >> valb) & 0x3F]);
-            valb -= 6;
-        }
-    }
-    if (valb > -6) encoded.push_back(encode_table[((val << 8) >> (valb + 8)) & 0x3F]);
-    while (encoded.size() % 4) encoded.push_back('=');
-    return encoded;
-}
+#include "utils/base64.h"
 
 enum class HttpMethod {
     GET,
@@ -74,6 +74,25 @@ public:
         return *incoming_.pop();
     }
 
+    // Messages are shared with the other subscribers of the queue, never copied
+    std::shared_ptr<Message const> do_receive_shared()override{
+        return incoming_.pop();
+    }
+
+    std::vector<std::shared_ptr<Message const>> do_receive_batch(size_t max_n, std::chrono::milliseconds max_wait)override{
+        std::vector<std::shared_ptr<Message const>> batch;
+        batch.push_back(incoming_.pop());
+        auto deadline = std::chrono::steady_clock::now() + max_wait;
+        while(batch.size() < max_n){
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            auto msg_ptr = incoming_.try_pop(std::max(left, std::chrono::milliseconds(0)));
+            if(! msg_ptr) break;
+            batch.push_back(std::move(* msg_ptr));
+        }
+        return batch;
+    }
+
     void do_send(MessageWrapper & msg_w)override{
         queue_.push(msg_w.msg_ptr());
     }
@@ -32,7 +32,6 @@ IN THE SOFTWARE.
 #include <atomic>
 #include <stdexcept>
 #include <random>
-#include <regex>
 
 #include <fmt/core.h>
 #include <jwt-cpp/jwt.h>
@@ -159,6 +158,7 @@ public:
         }catch(json::exception){
            throw std::runtime_error("Topic cannot be null for mqtt connector");
         }
+        topic_compiled_ = CompiledTemplate(topic_template_);
         // client_id
         try{
             client_id_ = json_descr.at("client_id").get<string>();
@@ -198,12 +198,6 @@ public:
             // default value is ""
         }
 
-        std::smatch match;
-        std::regex pattern("\\{\\{(.*?)\\}\\}");
-        is_topic_template_ = std::regex_search(
-            topic_template_.cbegin(), topic_template_.cend(), match, pattern
-        );
-
         // Create MQTT Client
         client_ptr_ = std::make_shared<mqtt::async_client>(
             server_, client_id_, mqtt::create_options(mqtt_version_), nullptr
@@ -245,16 +239,16 @@ public:
 
     void do_send(MessageWrapper & msg_w)override{
         string derived_topic;
-        if(is_topic_template_){
+        if(topic_compiled_.is_dynamic()){
             derived_topic = derive_topic(msg_w);
         }
-        string const & topic = is_topic_template_ ? derived_topic : topic_template_;
+        string const & topic = topic_compiled_.is_dynamic() ? derived_topic : topic_template_;
         try {
             mqtt::delivery_token_ptr pubtok;
             pubtok = client_ptr_->publish(
                 topic,
-                msg_w.msg().get_raw().c_str(),
-                msg_w.msg().get_raw().length(),
+                msg_w.view().get_raw().data(),
+                msg_w.view().get_raw().size(),
                 qos_,
                 false);
             pubtok->wait_for(TIMEOUT);
@@ -265,10 +259,50 @@ public:
         }
     }
 
+    // Publishes all messages before waiting for the first acknowledgement,
+    // so the batch costs one round trip instead of one per message
+    void do_send_batch(std::span<MessageWrapper> batch)override{
+        std::vector<mqtt::delivery_token_ptr> tokens;
+        tokens.reserve(batch.size());
+        try {
+            for(auto & msg_w : batch){
+                string derived_topic;
+                if(topic_compiled_.is_dynamic()){
+                    derived_topic = derive_topic(msg_w);
+                }
+                string const & topic = topic_compiled_.is_dynamic() ? derived_topic : topic_template_;
+                tokens.push_back(client_ptr_->publish(
+                    topic,
+                    msg_w.view().get_raw().data(),
+                    msg_w.view().get_raw().size(),
+                    qos_,
+                    false));
+            }
+            for(auto & pubtok : tokens){
+                pubtok->wait_for(TIMEOUT);
+            }
+        }
+        catch (const mqtt::exception& exc) {
+            std::cerr << exc << std::endl;
+            throw std::runtime_error("Unable to send message to MQTT server");
+        }
+    }
+
     Message const do_receive()override{
         mqtt::message mqtt_msg;
         msg_queue_->get(&mqtt_msg);  // blocking call
-        return Message(mqtt_msg.get_payload(), msg_format_, mqtt_msg.get_topic());
+        return make_message(mqtt_msg);
+    }
+
+    std::vector<std::shared_ptr<Message const>> do_receive_batch(size_t max_n, std::chrono::milliseconds max_wait)override{
+        std::vector<std::shared_ptr<Message const>> batch;
+        batch.push_back(do_receive_shared());
+        auto deadline = std::chrono::steady_clock::now() + max_wait;
+        mqtt::message mqtt_msg;
+        while(batch.size() < max_n && msg_queue_->try_get_until(&mqtt_msg, deadline)){
+            batch.push_back(std::make_shared<Message const>(make_message(mqtt_msg)));
+        }
+        return batch;
     }
 
     void do_stop()override{
@@ -276,7 +310,7 @@ public:
     }
 
     std::string derive_topic(MessageWrapper & msg_w){
-        return std::get<string>(SubsEngine(msg_w).substitute(topic_template_));
+        return std::get<string>(SubsEngine(msg_w).substitute(topic_compiled_));
     }
 
     static pair<string, json> get_schema()
@@ -356,6 +390,12 @@ public:
     }
 
 private:
+    Message make_message(mqtt::message const & mqtt_msg){
+        std::string const & payload = mqtt_msg.get_payload();
+        return Message(PayloadBuffer(std::string_view(payload)), msg_format_,
+                       topics_.intern(mqtt_msg.get_topic()));
+    }
+
     void parse_authbundle(){
         AuthbundleTable db;
         AuthBundle ab;
@@ -393,7 +433,7 @@ private:
     string client_id_;
     mqtt::async_client_ptr  client_ptr_;
     string topic_template_;
-    bool is_topic_template_ {false};
+    CompiledTemplate topic_compiled_;
     int n_retry_attempts_;
     int qos_;
     mqtt::connect_options conn_opts_;
@@ -404,6 +444,7 @@ private:
     bool verify_server_hostname_ {true};
     bool verify_server_certificate_ {true};
     string ca_certificate_file_;
+    TopicCache topics_;
 
 private:
     class Callback : public virtual mqtt::callback, public virtual mqtt::iaction_listener{
@@ -45,7 +45,7 @@ struct PostgreSQLConnectorConfig
     unsigned db_port;
     string table;
     vector<string> columns;
-    vector<string> values;
+    vector<CompiledTemplate> values;
 };
 
 
@@ -88,11 +88,13 @@ public:
         config_.db_port = config.at("db_port").get<unsigned>();
         config_.table = config.at("table").get<string>();
 
-        auto j_columns {config.at("columns")};
+        auto const & j_columns = config.at("columns");
         config_.columns = vector<string>(j_columns.begin(), j_columns.end());
 
-        auto j_values {config.at("values")};
-        config_.values = vector<string>(j_values.begin(), j_values.end());
+        auto const & j_values = config.at("values");
+        for(auto const & j_value : j_values){
+            config_.values.emplace_back(j_value.get<string>());
+        }
     }
 
     virtual void do_send(MessageWrapper & msg_w)
@@ -101,7 +103,8 @@ public:
 
         pqxx::params p;
         // Make sure vector does not reallocate elements as we use views
-        vector<substituted_t> row_values(config_.values.size());
+        vector<substituted_t> row_values;
+        row_values.reserve(config_.values.size());
 
         for(auto &vtemplate : config_.values){
             row_values.push_back(se.substitute(vtemplate));
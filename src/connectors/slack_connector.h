@@ -133,7 +133,7 @@ public:
     }
 
     void do_send(MessageWrapper& msg_w)override{
-        send_message(msg_w.msg().get_raw());
+        send_message(std::string(msg_w.view().get_raw()));
     }
 
     void do_disconnect()override{
@@ -43,7 +43,7 @@ struct SQLiteConnectorConfig
     string db_path;
     string table;
     vector<string> columns;
-    vector<string> values;
+    vector<CompiledTemplate> values;
 };
 
 
@@ -82,11 +82,13 @@ public:
         config_.db_path = config.at("db_path").get<string>();
         config_.table = config.at("table").get<string>();
 
-        auto j_columns {config.at("columns")};
+        auto const & j_columns = config.at("columns");
         config_.columns = vector<string>(j_columns.begin(), j_columns.end());
 
-        auto j_values {config.at("values")};
-        config_.values = vector<string>(j_values.begin(), j_values.end());
+        auto const & j_values = config.at("values");
+        for(auto const & j_value : j_values){
+            config_.values.emplace_back(j_value.get<string>());
+        }
     }
 
     void do_connect() override
@@ -95,26 +97,70 @@ public:
     }
 
     void do_send(MessageWrapper & msg_w) override
+    {
+        do_send_batch(std::span<MessageWrapper>(& msg_w, 1));
+    }
+
+    // The whole batch is inserted in one transaction with one prepared statement
+    void do_send_batch(std::span<MessageWrapper> batch) override
     {
         int res = sqlite3_open_v2(config_.db_path.c_str(), &db_, SQLITE_OPEN_READWRITE, nullptr);
         if( res != SQLITE_OK )
         {
+            sqlite3_close(db_);
             throw std::runtime_error("Can't open database: " + config_.db_path);
         }
 
-        sqlite3_stmt *stmt;
-        res = sqlite3_prepare_v2(db_, statement_.c_str(), -1, &stmt, nullptr);
-        if(res != SQLITE_OK){
+        sqlite3_stmt *stmt {nullptr};
+        auto fail = [this, &stmt](){
+            string error = sqlite3_errmsg(db_);
+            sqlite3_finalize(stmt);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
             sqlite3_close(db_);
-            throw std::runtime_error(sqlite3_errmsg(db_));
+            throw std::runtime_error(error);
+        };
+
+        if( sqlite3_exec(db_, "BEGIN", nullptr, nullptr, nullptr) != SQLITE_OK ) fail();
+
+        res = sqlite3_prepare_v2(db_, statement_.c_str(), -1, &stmt, nullptr);
+        if( res != SQLITE_OK ) fail();
+
+        for(auto & msg_w : batch){
+            // Bound values are not copied by SQLite, keep them and the engine
+            // their memoized modifier results point into until the step
+            auto se = SubsEngine(msg_w);
+            vector<substituted_t> row_values;
+            row_values.reserve(config_.values.size());
+            try{
+                bind_row(stmt, se, row_values);
+            }catch(...){
+                sqlite3_finalize(stmt);
+                sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+                sqlite3_close(db_);
+                throw;
+            }
+
+            res = sqlite3_step(stmt);
+            if (res != SQLITE_DONE) { fail(); }
+
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
         }
 
-        auto se = SubsEngine(msg_w);
+        res = sqlite3_finalize(stmt);
+        stmt = nullptr;
+        if (res != SQLITE_OK) { fail(); }
+
+        if( sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK ) fail();
+
+        res = sqlite3_close(db_);
+        if (res != SQLITE_OK) { throw std::runtime_error("Can't close database: " + config_.db_path); }
+    }
 
+    void bind_row(sqlite3_stmt * stmt, SubsEngine & se, vector<substituted_t> & row_values)
+    {
         // Build a query and do substitutions
         unsigned pix {0};
-        // Make sure vector does not reallocate elements as we use .c_str()
-        vector<substituted_t> row_values(config_.values.size());
 
         for(auto &vtemplate : config_.values){
             row_values.push_back(se.substitute(vtemplate));
@@ -150,15 +196,6 @@ public:
                 throw std::runtime_error("Unexpected substituted value!");
             }
         }
-
-        res = sqlite3_step(stmt);
-        if (res != SQLITE_DONE) { throw std::runtime_error(sqlite3_errmsg(db_)); }
-
-        res = sqlite3_finalize(stmt);
-        if (res != SQLITE_OK) { throw std::runtime_error(sqlite3_errmsg(db_)); }
-
-        res = sqlite3_close(db_);
-        if (res != SQLITE_OK) { throw std::runtime_error(sqlite3_errmsg(db_)); }
     }
 
     string build_statement()
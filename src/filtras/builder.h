@@ -28,7 +28,7 @@ IN THE SOFTWARE.
 
 
 #include "filtra.h"
-#include "substitutions/subs.hpp"
+#include "substitutions/template_writer.h"
 
 
 //_DOCS: SECTION_START builder_filtra Builder Filtra
@@ -46,50 +46,89 @@ Creates a new message::
       }
     }
 
+The payload template is serialized once, when the filtra is created; building
+a message only substitutes its {{...}} expressions and writes the result,
+encoded as JSON or CBOR, directly into the new payload. Binary values, such
+as an image from *EXTRA*, are embedded as CBOR byte strings or, in JSON, as
+base64 strings.
 */
 //_DOCS: END
 
 class BuilderFT: public Filtra
 {
-    json payload_;
-    json extra_;
+    TemplateWriter payload_;
+    bool has_payload_ {false};
+    // Extra values are stored as JSON text, one writer per key
+    std::vector<pair<string, TemplateWriter>> extra_;
+    // Size of the last payload built, to allocate the next one at once
+    size_t payload_size_hint_ {0};
 
 public:
     BuilderFT(PipelineIface const & pi, json const & config)
             :Filtra(pi, config)
     {
-        if( config.contains("payload") )
+        auto encoding = TemplateWriter::Encoding::JSON;
+        string const & encoder = config.value("encoder", "json");
+        if( encoder == "cbor" )
         {
-            payload_ = config.at("payload");
+            encoding = TemplateWriter::Encoding::CBOR;
+        }
+        else if( encoder != "json" )
+        {
+            throw configuration_error(fmt::format("Builder: unknown encoder '{}'!", encoder));
+        }
+
+        if( config.contains("payload") && ! config.at("payload").empty() )
+        {
+            payload_ = TemplateWriter(config.at("payload"), encoding);
+            has_payload_ = true;
         }
 
         if( config.contains("extra") )
         {
-            extra_ = config.at("extra");
+            json const & extra = config.at("extra");
+            if( ! extra.is_object() )
+            {
+                throw configuration_error("Builder: extra must be an object!");
+            }
+            for( auto const & [key, val] : extra.items() )
+            {
+                extra_.emplace_back(key, TemplateWriter(val, TemplateWriter::Encoding::JSON));
+            }
         }
     }
 
     string process_message( MessageWrapper & msg_w )override
     {
-        if( !payload_.empty() )
+        if( has_payload_ )
         {
-            json payload = payload_;
-            build(payload, msg_w);
+            string payload;
+            payload.reserve(payload_size_hint_);
+            {
+                auto se = SubsEngine(msg_w);
+                payload_.write(se, payload);
+            }
+            payload_size_hint_ = payload.size();
+
+            auto format = payload_.encoding() == TemplateWriter::Encoding::CBOR ?
+                MessageFormat::Type::CBOR : MessageFormat::Type::JSON;
+            // The json tree is only decoded if a later filtra reads it
             msg_w.set_message(
-                Message(payload, MessageFormat::Type::JSON, msg_w.msg().get_topic())
+                Message(PayloadBuffer(std::move(payload)), format, msg_w.view().get_topic_ptr())
             );
         }
 
         if( ! extra_.empty() )
         {
-            json extra = extra_;
-            build(extra, msg_w);
-
+            // Extra templates see the message built above
+            auto se = SubsEngine(msg_w);
             auto & extra_storage = msg_w.get_extra();
 
-            for( auto & [key, val] : extra.items() )
+            for( auto const & [key, writer] : extra_ )
             {
-                extra_storage.add_extra(key, val.dump());
+                string value;
+                writer.write(se, value);
+                extra_storage.add_extra(key, std::move(value));
             }
         }
 
@@ -107,7 +146,7 @@ public:
                 {"type_properties", {
                     {"encoder", {
                         {"type", "string"},
-                        {"options", {"json"}},
+                        {"options", {"json", "cbor"}},
                         {"default", "json"},
                         {"required", true}
                     }},
@@ -125,88 +164,6 @@ public:
         //_DOCS: END
         return {"builder", schema};
     }
-
-private:
-    void build( json & output, MessageWrapper &msg_w )
-    {
-        auto se = SubsEngine(msg_w);
-
-        if( output.is_object() )
-        {
-            substitute(se, output);
-        }
-        else if( output.is_string() )
-        {
-            output = substitute(se, output.get<string>());
-        }
-        else{
-            throw std::runtime_error("Can not build!");
-        }
-    }
-
-    void substitute(SubsEngine & se, json & j){
-        for(auto it = j.begin(); it != j.end(); ++it){
-            if( it->is_string() )
-            {
-                auto result = se.substitute(it.value());
-
-                if( std::holds_alternative<string>(result) )
-                {
-                    it.value() = std::get<string>(result);
-                }
-                else if( std::holds_alternative<double>(result) )
-                {
-                    it.value() = std::get<double>(result);
-                }
-                else if( std::holds_alternative<long>(result) )
-                {
-                    it.value() = std::get<long>(result);
-                }
-                else if( std::holds_alternative<bool>(result) )
-                {
-                    it.value() = std::get<bool>(result);
-                }
-                else if( std::holds_alternative<json>(result) )
-                {
-                    it.value() = std::get<json>(result);
-                }
-                else if( std::holds_alternative<std::span<const std::byte>>(result) )
-                {
-                    auto v = std::get<std::span<const std::byte>>(result);
-                    auto j = json::array();
-                    for(const auto & s : v )
-                    {
-                        j.push_back(s);
-                    }
-                    it.value() = std::move(j);
-                }
-                else if( std::holds_alternative<std::vector<unsigned char>>(result) )
-                {
-                    auto v = std::get<std::vector<unsigned char>>(result);
-                    auto j = json::array();
-                    for( const auto & s : v )
-                    {
-                        j.push_back(s);
-                    }
-                    it.value() = std::move(j);
-                }
-                else{
-                    throw std::runtime_error("Unexpected substituted value!");
-                }
-            }else if(it->is_object() || it->is_array()){
-                substitute(se, *it);
-            }
-        }
-    }
-
-    json substitute(SubsEngine & se, string const & s){
-        auto result = se.substitute(s);
-        if(std::holds_alternative<string>(result)){
-            return std::get<string>(result);
-        }else{
-            return std::get<json>(result);
-        }
-    }
 };
 
 
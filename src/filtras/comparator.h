@@ -77,10 +77,13 @@ public:
     }
 
     string process_message(MessageWrapper & msg_w)override{
-        json const & payload = msg_w.msg().get_json();
         bool res = false;
         try{
-            json const & j_value = payload.at(value_key_);
+            auto value = msg_w.view().get_json_member(value_key_);
+            if(! value){
+                throw std::invalid_argument("json");
+            }
+            json const & j_value = * value;
             if(j_value.is_number_float()){
                 if(std::holds_alternative<double>(comparand_)){
                     res = compare(j_value.get<double>(), std::get<double>(comparand_));
@@ -27,80 +27,288 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_CONVERTER_FT_H__
 
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include <lua.hpp>
 
+#include "m2e_exceptions.h"
 #include "filtra.h"
 #include "database/converter.h"
+#include "utils/lua_bridge.h"
 
 extern "C" {
     extern int luaopen_cjson(lua_State *L);
 }
 
 
+/*
+Converter code compiled to Lua bytecode, shared by the converters of all
+pipeline workers. An entry is compiled again only when its code changes.
+*/
+class LuaBytecodeCache
+{
+public:
+    struct Entry{
+        string code;
+        string bytecode;
+    };
+
+    static std::shared_ptr<Entry const> get(string const & converter_id, string const & code){
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto & entry = entries_[converter_id];
+        if( ! entry || entry->code != code ){
+            entry = std::make_shared<Entry const>(Entry{code, compile(converter_id, code)});
+        }
+        return entry;
+    }
+
+private:
+    static inline std::mutex mtx_;
+    static inline std::map<string, std::shared_ptr<Entry const>> entries_;
+
+    static string compile(string const & name, string const & code){
+        lua_State * L = luaL_newstate();
+        if( luaL_loadbufferx(L, code.data(), code.size(), name.c_str(), "t") ){
+            string error = lua_tostring(L, -1);
+            lua_close(L);
+            throw std::runtime_error(error);
+        }
+        string bytecode;
+        lua_dump(L, [](lua_State *, void const * p, size_t sz, void * ud){
+            static_cast<string *>(ud)->append(static_cast<char const *>(p), sz);
+            return 0;
+        }, & bytecode, 0);
+        lua_close(L);
+        return bytecode;
+    }
+};
+
+
+enum class LuaPayload {STRING, VIEW, TABLE};
+
+
 //_DOCS: SECTION_START lua_converter_filtra Lua Converter Filtra
 /*!
 Converts messages with a custom Lua script::
 
     {
       "type": "lua_converter",
-      "converter_id": "<converter_id>"
+      "converter_id": "<converter_id>",
+      "payload": "string"
     }
 
+The script defines a function *convert(payload)* returning the new payload.
+How the payload is passed depends on *payload*:
+
+- *string*: as a Lua string, a copy of the payload.
+- *view*: as a read-only view of the payload, without copying it. It supports
+  ``#view``, ``tostring(view)``, ``view:sub(i, j)``, ``view:byte(i)`` and
+  ``view:find(text, init)``, and can not be used after *convert* returns.
+- *table*: as a Lua table built from the decoded JSON or CBOR payload, which
+  saves decoding it again with *cjson*. JSON null is *cjson.null*.
+
+*convert* may return a string, or a table which is encoded in the format of the
+message. Each pipeline worker runs its own Lua state, the code is compiled once
+and loaded as bytecode.
+
+A script may also define *convert_batch(payloads)*, taking an array of payloads
+and returning an array of results in the same order. When the converter is the
+first filtra of the pipeline, it is called once for up to 64 messages, instead
+of calling *convert* for each. Without *convert*, single messages are passed to
+*convert_batch* as arrays of one. If *convert_batch* fails or returns a bad
+result, the messages of the batch are converted one by one again, so only the
+failing ones are lost.
 */
 //_DOCS: END
 
 class LuaConverterFT: public Filtra
 {
     string converter_id_;
-    string lua_code_;
+    LuaPayload payload_ {LuaPayload::STRING};
+    std::shared_ptr<LuaBytecodeCache::Entry const> chunk_;
     lua_State * L_ = nullptr;
+    int convert_ref_ = LUA_NOREF;
+    int convert_batch_ref_ = LUA_NOREF;
+    // Views passed to the running call
+    std::vector<lua_bridge::PayloadView *> views_;
 
     void load_lua_code(){
         ConverterTable ct;
         Converter c;
         bool res = ct.get(converter_id_, c);
-        if(res){
-            lua_code_ = c.code;
-            L_ = luaL_newstate();
-            luaL_requiref(L_, "base", luaopen_base, 1);
-            luaL_requiref(L_, "string", luaopen_string, 1);
-            luaL_requiref(L_, "utf8", luaopen_utf8, 1);
-            luaL_requiref(L_, "table", luaopen_table, 1);
-            luaL_requiref(L_, "math", luaopen_math, 1);
-            luaL_requiref(L_, "cjson", luaopen_cjson, 1);
-            lua_pop(L_, 6);  // Must be equal to number of luaL_requiref calls!
-            if(luaL_dostring(L_, lua_code_.c_str())){
-                throw std::runtime_error(lua_tostring(L_, -1));
-            }
-        }else{
+        if(! res){
             throw std::runtime_error("Not able to retreive converter code!");
         }
+        auto chunk = LuaBytecodeCache::get(converter_id_, c.code);
+        // Unchanged code keeps its state, with the globals the script set
+        if(L_ && chunk == chunk_) return;
+        close_state();
+
+        L_ = luaL_newstate();
+        luaL_requiref(L_, "base", luaopen_base, 1);
+        luaL_requiref(L_, "string", luaopen_string, 1);
+        luaL_requiref(L_, "utf8", luaopen_utf8, 1);
+        luaL_requiref(L_, "table", luaopen_table, 1);
+        luaL_requiref(L_, "math", luaopen_math, 1);
+        luaL_requiref(L_, "cjson", luaopen_cjson, 1);
+        lua_pop(L_, 6);  // Must be equal to number of luaL_requiref calls!
+        lua_bridge::register_payload_view(L_);
+
+        auto const & bytecode = chunk->bytecode;
+        if(luaL_loadbufferx(L_, bytecode.data(), bytecode.size(), converter_id_.c_str(), "b")
+                || lua_pcall(L_, 0, 0, 0)){
+            string error = lua_tostring(L_, -1);
+            close_state();
+            throw std::runtime_error(error);
+        }
+        convert_ref_ = function_ref("convert");
+        convert_batch_ref_ = function_ref("convert_batch");
+        if(convert_ref_ == LUA_NOREF && convert_batch_ref_ == LUA_NOREF){
+            close_state();
+            throw std::runtime_error("Converter defines neither convert nor convert_batch!");
+        }
+        chunk_ = std::move(chunk);
+    }
+
+    int function_ref(char const * name){
+        lua_getglobal(L_, name);
+        if(! lua_isfunction(L_, -1)){
+            lua_pop(L_, 1);
+            return LUA_NOREF;
+        }
+        return luaL_ref(L_, LUA_REGISTRYINDEX);
+    }
+
+    void close_state(){
+        if(L_) lua_close(L_);
+        L_ = nullptr;
+        convert_ref_ = LUA_NOREF;
+        convert_batch_ref_ = LUA_NOREF;
+        chunk_.reset();
     }
+
 public:
     LuaConverterFT(PipelineIface const & pi, json const & config):
             Filtra(pi, config){
         converter_id_ = config.at("converter_id").get<string>();
+        string const & payload = config.value("payload", "string");
+        if(payload == "string"){
+            payload_ = LuaPayload::STRING;
+        }else if(payload == "view"){
+            payload_ = LuaPayload::VIEW;
+        }else if(payload == "table"){
+            payload_ = LuaPayload::TABLE;
+        }else{
+            throw configuration_error(fmt::format("Lua converter: unknown payload '{}'!", payload));
+        }
+    }
+
+    ~LuaConverterFT(){
+        close_state();
     }
 
     void start()override{
-        if(L_) lua_close(L_);
         load_lua_code();
     }
 
-    string process_message(MessageWrapper &msg_w)override{
-        Message msg = msg_w.msg();
-        string raw = msg.get_raw();
+    bool takes_batches() const override{
+        return convert_batch_ref_ != LUA_NOREF;
+    }
 
-        lua_getglobal(L_, "convert");
-        lua_pushlstring(L_, raw.data(), raw.size());
-        if(lua_pcall(L_, 1, 1, 0)){
-            throw std::runtime_error(lua_tostring(L_, -1));
+    string process_message(MessageWrapper &msg_w)override{
+        if(convert_ref_ == LUA_NOREF){
+            process_batch(std::span<MessageWrapper>(& msg_w, 1));
+            return "";
         }
-        msg_w.msg().get_raw() =  lua_tostring(L_, -1);
+        // A failed conversion may leave values behind
+        lua_settop(L_, 0);
+        lua_rawgeti(L_, LUA_REGISTRYINDEX, convert_ref_);
+        push_payload(msg_w.view());
+        call();
+        string result = encode_result(msg_w.view(), -1);
+        lua_pop(L_, 1);
+        msg_w.mut().set_raw(std::move(result));
         msg_w.pass();
         return "";
     }
 
+protected:
+    // convert_batch receives an array of payloads and returns an array of results
+    void process_batch(std::span<MessageWrapper> batch)override{
+        lua_settop(L_, 0);
+        lua_rawgeti(L_, LUA_REGISTRYINDEX, convert_batch_ref_);
+        lua_createtable(L_, static_cast<int>(batch.size()), 0);
+        for(size_t i = 0; i < batch.size(); ++i){
+            push_payload(batch[i].view());
+            lua_rawseti(L_, -2, static_cast<lua_Integer>(i + 1));
+        }
+        call();
+        if(! lua_istable(L_, -1) || lua_rawlen(L_, -1) != batch.size()){
+            throw std::runtime_error("convert_batch must return one result per payload!");
+        }
+        std::vector<string> results;
+        results.reserve(batch.size());
+        for(size_t i = 0; i < batch.size(); ++i){
+            lua_rawgeti(L_, -1, static_cast<lua_Integer>(i + 1));
+            results.push_back(encode_result(batch[i].view(), -1));
+            lua_pop(L_, 1);
+        }
+        lua_pop(L_, 1);
+        // Only a batch without a bad result changes the messages
+        for(size_t i = 0; i < batch.size(); ++i){
+            batch[i].mut().set_raw(std::move(results[i]));
+            batch[i].pass();
+        }
+    }
+
+private:
+    void push_payload(Message const & msg){
+        if(payload_ == LuaPayload::STRING){
+            std::string_view raw = msg.get_raw();
+            lua_pushlstring(L_, raw.data(), raw.size());
+        }else if(payload_ == LuaPayload::VIEW){
+            views_.push_back(lua_bridge::push_payload_view(L_, msg.get_raw()));
+        }else{
+            lua_bridge::push_json(L_, msg.get_json());
+        }
+    }
+
+    // Calls the function below its argument, the payload views expire with the call
+    void call(){
+        int failed = lua_pcall(L_, 1, 1, 0);
+        for(auto view : views_){
+            lua_bridge::invalidate(view);
+        }
+        views_.clear();
+        if(failed){
+            char const * error = lua_tostring(L_, -1);
+            throw std::runtime_error(error ? error : "Converter failed!");
+        }
+    }
+
+    // The result at idx as the new payload of msg, tables are encoded in its format
+    string encode_result(Message const & msg, int idx){
+        if(lua_istable(L_, idx)){
+            json result = lua_bridge::to_json(L_, idx);
+            string encoded;
+            if(msg.get_format() == MessageFormat::Type::CBOR){
+                json::to_cbor(result, encoded);
+            }else{
+                encoded = result.dump();
+            }
+            return encoded;
+        }
+        size_t len;
+        char const * result = lua_tolstring(L_, idx, & len);
+        if(result == nullptr){
+            throw std::runtime_error("Converter must return a string or a table!");
+        }
+        return string(result, len);
+    }
+
+public:
     static pair<string, json> get_schema(){
         //_DOCS: SCHEMA_START lua_converter_filtra
         //_DOCS: SCHEMA_INCLUDE filtra
@@ -112,6 +320,17 @@ public:
                         {"type", "string"},
                         {"options", "api/converter/id"},
                         {"required", true}
+                    }},
+                    {"payload", {
+                        {"type", "string"},
+                        {"options", json::array_t{
+                            {"string", "a copy of the payload as a Lua string"},
+                            {"view", "a read-only view of the payload"},
+                            {"table", "a Lua table of the decoded payload"}
+                        }},
+                        {"default", "string"},
+                        {"required", false},
+                        {"description", "How the payload is passed to convert."}
                     }}
                 }}
             }
@@ -27,6 +27,8 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_FILTRA_H__
 
 
+#include <span>
+
 #include "m2e_aliases.h"
 #include "pipeline_iface.h"
 #include "m2e_message/message_wrapper.h"
@@ -47,18 +49,9 @@ public:
 
         logical_negation_ = config.value("logical_negation", false);
 
-        if(config.contains("queues")){
-            json const & j_queues = config.at("queues");
-            queue_ids_ = vector<string>(j_queues.begin(), j_queues.end());
-        }
-
         if(config.contains("metadata")){
             metadata_ = config.at("metadata");
         }
-
-        string goto_hop = config.value("goto", "");
-        hops_.first = config.value("goto_passed", goto_hop);
-        hops_.second = config.value("goto_rejected", goto_hop);
     }
     virtual ~Filtra(){}
     string process(MessageWrapper & msg_w){
@@ -71,9 +64,21 @@ public:
         return generate_message();
     }
 
-    vector<string> const & get_destinations(){return queue_ids_;}
+    // Processes the messages in order, in one call where the filtra takes batches
+    void process(std::span<MessageWrapper> batch){
+        for(auto & msg_w : batch){
+            msg_w.add_metadata(metadata_);
+        }
+        process_batch(batch);
+    }
+
+    // A filtra which gains from seeing several messages at once, e.g. by crossing
+    // into a script once, overrides this and process_batch. It must not generate
+    // messages, batches have no "self" hop. A process_batch which throws must
+    // leave the messages untouched, the pipeline then processes them one by one.
+    virtual bool takes_batches() const {return false;}
+
     string const & get_name(){return name_;}
-    hops_t const & get_hops(){return hops_;}
 
     virtual void start() {}
     virtual void stop() {}
@@ -126,14 +131,17 @@ public:
 protected:
     virtual string process_message(MessageWrapper &msg_w) = 0;
     virtual Message generate_message(){return Message();}
+    virtual void process_batch(std::span<MessageWrapper> batch){
+        for(auto & msg_w : batch){
+            process_message(msg_w);
+        }
+    }
 
     MessageFormat::Type msg_format_ {MessageFormat::Type::UNKN};
     bool logical_negation_ {false};
-    vector<string> queue_ids_;
 
 private:
     string name_;
-    hops_t hops_;
     json metadata_;
 };
 
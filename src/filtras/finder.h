@@ -27,12 +27,16 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_FINDER_FT_H__
 
 
+#include <memory>
 #include <variant>
 
+#include "m2e_exceptions.h"
 #include "filtra.h"
+#include "utils/aho_corasick.h"
+#include "utils/regex_dfa.h"
 
 
-enum class SearchOperator {UNKN, CONTAIN, CONTAINED, MATCH};
+enum class SearchOperator {UNKN, CONTAIN, CONTAINED, MATCH, REGEX};
 
 
 namespace
@@ -40,7 +44,8 @@ namespace
     //_DOCS: STRINGS_START
     constexpr std::string_view _DOCS_PR_DESC_TEXT =
         "Specifies a string that can either be searched as a substring within"
-        " the payload or used to search for the payload as a substring.";
+        " the payload or used to search for the payload as a substring."
+        " With the *regex* operator, it is a regular expression.";
 
     constexpr std::string_view _DOCS_PR_DESC_KEYS =
         "Specifies the keys in the decoded payload dictionary. All keys must"
@@ -49,6 +54,11 @@ namespace
     constexpr std::string_view _DOCS_PR_DESC_VALUE_KEY =
         "Specifies a key in the decoded payload whose value is used"
         " for the text search.";
+
+    constexpr std::string_view _DOCS_PR_DESC_PATTERNS =
+        "Specifies strings searched for in the payload in a single pass."
+        " The message passes if any of them is found, the first found one"
+        " is stored in the metadata as *matched_pattern*.";
     //_DOCS: END
 }
 
@@ -88,6 +98,26 @@ Three variants are supported:
           "text": "LOG",
           "value_key": "key1"
       }
+
+   With the *regex* operator, *text* is a regular expression searched for in the
+   payload. It is compiled once when the filtra is created and matched in time
+   linear in the payload; back references and look arounds are not supported::
+
+      {
+          "type": "finder",
+          "operator": "regex",
+          "text": "^temp/[0-9]+: (ERROR|FATAL)"
+      }
+
+4. Searches for any of several *patterns* within the payload, or within the value
+   of *value_key*, scanning it once. The first found pattern is added to the
+   metadata as *matched_pattern*::
+
+      {
+          "type": "finder",
+          "patterns": ["ERROR", "FATAL", "panic"],
+          "case_insensitive": true
+      }
 */
 //_DOCS: END
 
@@ -104,12 +134,23 @@ public:
             operator_ = SearchOperator::CONTAINED;
         }else if (oper == "match"){
             operator_ = SearchOperator::MATCH;
+        }else if (oper == "regex"){
+            operator_ = SearchOperator::REGEX;
         }
 
         if(config.contains("text")){
             text_ = config["text"];
         }
 
+        if(operator_ == SearchOperator::REGEX){
+            try{
+                regex_ = std::make_unique<DfaRegex>(
+                    text_, config.value("case_insensitive", false));
+            }catch(std::invalid_argument const & e){
+                throw configuration_error(e.what());
+            }
+        }
+
         if(config.contains("keys")){
             json j_keys = config["keys"];
             keys_ = vector<string>(j_keys.begin(), j_keys.end());
@@ -118,6 +159,16 @@ public:
         if(config.contains("value_key")){
             value_key_ = config["value_key"];
         }
+
+        if(config.contains("patterns")){
+            patterns_ = config["patterns"].get<vector<string>>();
+            try{
+                matcher_ = std::make_unique<AhoCorasick>(
+                    patterns_, config.value("case_insensitive", false));
+            }catch(std::invalid_argument const & e){
+                throw configuration_error(e.what());
+            }
+        }
     }
 
     string process_message(MessageWrapper & msg_w) override
@@ -131,13 +182,17 @@ public:
             if(value_key_.size() > 0){
                 res &= find_in_value(msg_w);
             }else{
-                res &= find_in_string(msg_w.msg().get_raw());
+                res &= find_in_string(msg_w.view().get_raw());
             }
         }
         if(res && keys_.size() > 0){
             checked = true;
             res &= find_in_keys(msg_w);
         }
+        if(res && matcher_){
+            checked = true;
+            res &= find_patterns(msg_w);
+        }
         res = checked && res;
         res = logical_negation_ ? ! res : res;
         if(res){
@@ -148,13 +203,15 @@ public:
         return "";
     }
 
-    bool find_in_string(string const & msg_string){
+    bool find_in_string(std::string_view msg_string){
         if(operator_ == SearchOperator::CONTAIN){
             return msg_string.find(text_) != std::string::npos;
         }else if(operator_ == SearchOperator::CONTAINED){
             return text_.find(msg_string) != std::string::npos;
         }else if(operator_ == SearchOperator::MATCH){
             return text_ == msg_string;
+        }else if(operator_ == SearchOperator::REGEX){
+            return regex_->search(msg_string);
         }else{
             return false;
         }
@@ -162,9 +219,9 @@ public:
 
     bool find_in_keys(MessageWrapper & msg_w){
         if(msg_format_ == MessageFormat::Type::JSON){
-            json const & j_payload = msg_w.msg().get_json();
+            Message const & msg = msg_w.view();
             for(auto const & key : keys_){
-                if(! j_payload.contains(key)){
+                if(! msg.has_json_member(key)){
                     return false;
                 }
             }
@@ -173,11 +230,26 @@ public:
         return false;
     }
 
+    bool find_patterns(MessageWrapper & msg_w){
+        int ix = AhoCorasick::NO_MATCH;
+        if(value_key_.size() > 0){
+            if(msg_format_ != MessageFormat::Type::JSON) return false;
+            auto value = msg_w.view().get_json_member(value_key_);
+            if(! value) return false;
+            ix = matcher_->find_first(value->get_ref<string const &>());
+        }else{
+            ix = matcher_->find_first(msg_w.view().get_raw());
+        }
+        if(ix == AhoCorasick::NO_MATCH) return false;
+        msg_w.add_metadata({{"matched_pattern", patterns_[ix]}});
+        return true;
+    }
+
     bool find_in_value(MessageWrapper & msg_w){
         if(msg_format_ == MessageFormat::Type::JSON){
-            json const & j_payload = msg_w.msg().get_json();
-            if(j_payload.contains(value_key_)){
-                return find_in_string(j_payload[value_key_]);
+            auto value = msg_w.view().get_json_member(value_key_);
+            if(value){
+                return find_in_string(value->get_ref<string const &>());
             }else{
                 return false;
             }
@@ -196,7 +268,8 @@ public:
                     {"options", json::array_t{
                         {"contain", "searches for *text* within the payload"},
                         {"contained", "searches for the payload within *text*"},
-                        {"match", "checks if *text* exactly matches the payload"}
+                        {"match", "checks if *text* exactly matches the payload"},
+                        {"regex", "searches for the regular expression *text* within the payload"}
                     }},
                     {"default", "match"},
                     {"required", true},
@@ -218,6 +291,18 @@ public:
                     {"required", false},
                     {"description", _DOCS_PR_DESC_VALUE_KEY}
                 }},
+                {"patterns", {
+                    {"type", "array"},
+                    {"items", {{"type", "string"}}},
+                    {"required", false},
+                    {"description", _DOCS_PR_DESC_PATTERNS}
+                }},
+                {"case_insensitive", {
+                    {"type", "boolean"},
+                    {"default", false},
+                    {"required", false},
+                    {"description", "Matches *patterns* or the *regex* ignoring the case of ASCII letters."}
+                }},
                 {"decoder", {
                     {"type", "string"},
                     {"options", {"json", "raw"}},
@@ -236,6 +321,9 @@ private:
     std::string text_;
     vector<string> keys_;
     std::string value_key_;
+    vector<string> patterns_;
+    std::unique_ptr<AhoCorasick> matcher_;
+    std::unique_ptr<DfaRegex> regex_;
 };
 
 
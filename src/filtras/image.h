@@ -27,21 +27,27 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_IMAGE_FT_H__
 
 
-#include <opencv2/opencv.hpp>
-#include <opencv2/imgcodecs.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 
+#include "m2e_exceptions.h"
 #include "filtra.h"
+#include "utils/executor.h"
+#include "utils/image_scaler.h"
 
 
 struct ImageFTOperation
 {
-    enum class Type{ UNKN, RESIZE };
+    enum class Type{ UNKN, RESIZE, RENDITIONS };
 
     static std::string to_string(ImageFTOperation::Type v)
     {
         switch(v){
             case Type::UNKN: return "unkn";
             case Type::RESIZE: return "resize";
+            case Type::RENDITIONS: return "renditions";
             default: throw std::invalid_argument("Invalid ImageFTOperation");
         }
     }
@@ -53,6 +59,7 @@ struct ImageFTOperation
 
         if( str == "unkn" ){ return ImageFTOperation::Type::UNKN; }
         if( str == "resize" ){ return ImageFTOperation::Type::RESIZE; }
+        if( str == "renditions" ){ return ImageFTOperation::Type::RENDITIONS; }
 
         throw std::invalid_argument("Unknown format: " + str);
     }
@@ -65,44 +72,148 @@ Creates a new message::
 
     {
       "type": "image",
-      "operation": "<operation>"
+      "operation": "resize",
+      "width": 800,
+      "height": 600
     }
 
+With only one of *width* and *height*, the other follows the aspect ratio of the
+image. Large JPEG images are decoded directly at a reduced resolution when the
+target size allows it.
+
+The *renditions* operation decodes the image once and stores several renditions
+of it as extras. Each has its own size, *format* (jpeg, webp or png) and
+*quality*; without a size it keeps the size of the image. With *parallel*, the
+renditions are encoded concurrently::
+
+    {
+      "type": "image",
+      "operation": "renditions",
+      "parallel": true,
+      "renditions": [
+        {"extra": "thumbnail", "width": 160, "format": "webp", "quality": 75},
+        {"extra": "preview", "width": 1024},
+        {"extra": "original", "format": "png"}
+      ]
+    }
 */
 //_DOCS: END
 
+/*
+Renditions of one decoded image encoded on the Executor. The calling thread
+encodes every rendition no task has started yet, so it waits only for renditions
+being encoded, never for a task still queued. Tasks hold the job, they may run
+after the message is done and find nothing left to do.
+*/
+struct ImageRenditionJob
+{
+    cv::Mat decoded;
+    std::span<ImageScaler const> scalers;
+    vector<uchars> results;
+    vector<std::exception_ptr> errors;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t remaining;
+
+    ImageRenditionJob(std::span<ImageScaler const> scalers):
+        scalers(scalers), results(scalers.size()), errors(scalers.size()),
+        claimed(new std::atomic<bool>[scalers.size()]()), remaining(scalers.size()) {}
+
+    void run(size_t ix)
+    {
+        if( claimed[ix].exchange(true) ) return;
+        try{
+            cv::Mat scratch;
+            scalers[ix].encode(decoded, scratch, results[ix]);
+        }catch(...){
+            errors[ix] = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        if( --remaining == 0 ) cv.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this]{ return remaining == 0; });
+    }
+};
+
+
 class ImageFT: public Filtra
 {
     ImageFTOperation::Type operation_;
     string extra_;
+    std::unique_ptr<ImageScaler> scaler_;
+    // Renditions, the extra names match the scalers by index
+    vector<ImageScaler> rendition_scalers_;
+    vector<string> rendition_extras_;
+    bool parallel_ {false};
+    TaskRunner & runner_;
+
 public:
-    ImageFT(PipelineIface const & pi, json const & config): Filtra(pi, config)
+    static constexpr int DEFAULT_WIDTH = 800;
+    static constexpr int DEFAULT_HEIGHT = 600;
+
+    // Parallel renditions are encoded on runner
+    ImageFT(PipelineIface const & pi, json const & config,
+            TaskRunner & runner = Executor::get_instance()): Filtra(pi, config), runner_(runner)
     {
         operation_ = ImageFTOperation::from_string(config.at("operation").get<string>());
         extra_ = config.value("extra", "");
+        parallel_ = config.value("parallel", false);
+
+        try{
+            if( operation_ == ImageFTOperation::Type::RENDITIONS )
+            {
+                for( auto const & rendition : config.at("renditions") )
+                {
+                    rendition_extras_.push_back(rendition.at("extra").get<string>());
+                    rendition_scalers_.emplace_back(
+                        rendition.value("width", 0),
+                        rendition.value("height", 0),
+                        rendition.value("quality", ImageScaler::DEFAULT_QUALITY),
+                        ImageScaler::format_from_string(rendition.value("format", "jpeg")));
+                }
+                if( rendition_scalers_.empty() )
+                {
+                    throw std::invalid_argument("Image renditions are not specified!");
+                }
+            }
+            else
+            {
+                bool has_size = config.contains("width") || config.contains("height");
+                int width = config.value("width", has_size ? 0 : DEFAULT_WIDTH);
+                int height = config.value("height", has_size ? 0 : DEFAULT_HEIGHT);
+                scaler_ = std::make_unique<ImageScaler>(
+                    width, height, config.value("quality", ImageScaler::DEFAULT_QUALITY));
+            }
+        }catch(std::invalid_argument const & e){
+            throw configuration_error(e.what());
+        }catch(json::exception const & e){
+            throw configuration_error(e.what());
+        }
     }
 
     string process_message(MessageWrapper &msg_w) override
     {
-        // Load the image
-        auto payload = msg_w.msg().get_payload_uchar();
-        auto original = cv::imdecode(payload, cv::IMREAD_COLOR);
-
-        cv::Size new_size(800, 600);  // width x height
-        cv::Mat resized;
-        cv::resize(original, resized, new_size, 0, 0, cv::INTER_LINEAR);
-
-        vector<int> params = { cv::IMWRITE_JPEG_QUALITY, 90 };
+        if( operation_ == ImageFTOperation::Type::RENDITIONS )
+        {
+            make_renditions(msg_w);
+            msg_w.pass();
+            return "";
+        }
 
+        uchars const & result = scaler_->resize(msg_w.view().get_payload_uchar());
         if( extra_.empty() )
         {
-            cv::imencode(".jpeg", resized, payload, params);
+            msg_w.mut().set_raw(std::string_view(
+                reinterpret_cast<char const *>(result.data()), result.size()));
         }
         else
         {
-            uchars payload;
-            cv::imencode(".jpeg", resized, payload, params);
-            msg_w.get_extra().add_extra(extra_, std::move(payload));
+            msg_w.get_extra().add_extra(extra_, result);
         }
 
         msg_w.pass();
@@ -118,19 +229,99 @@ public:
             {"type_properties", {
                 {"operation", {
                     {"type", "string"},
-                    {"options", {"resize"}},
+                    {"options", {"resize", "renditions"}},
                     {"required", true},
                     {"description", "Image transformation operation."}
                 }},
+                {"width", {
+                    {"type", "integer"},
+                    {"default", DEFAULT_WIDTH},
+                    {"required", false},
+                    {"description", "Target width in pixels."}
+                }},
+                {"height", {
+                    {"type", "integer"},
+                    {"default", DEFAULT_HEIGHT},
+                    {"required", false},
+                    {"description", "Target height in pixels."}
+                }},
+                {"quality", {
+                    {"type", "integer"},
+                    {"default", ImageScaler::DEFAULT_QUALITY},
+                    {"required", false},
+                    {"description", "JPEG quality, from 0 to 100."}
+                }},
                 {"extra", {
                     {"type", "object"},
                     {"required", false}
+                }},
+                {"renditions", {
+                    {"type", "array"},
+                    {"items", {
+                        {"type", "object"},
+                        {"properties", {
+                            {"extra", {{"type", "string"}, {"required", true}}},
+                            {"width", {{"type", "integer"}, {"required", false}}},
+                            {"height", {{"type", "integer"}, {"required", false}}},
+                            {"format", {{"type", "string"}, {"options", {"jpeg", "webp", "png"}},
+                                        {"default", "jpeg"}, {"required", false}}},
+                            {"quality", {{"type", "integer"}, {"default", ImageScaler::DEFAULT_QUALITY},
+                                         {"required", false}}}
+                        }}
+                    }},
+                    {"required", false},
+                    {"description", "Renditions made by the *renditions* operation."}
+                }},
+                {"parallel", {
+                    {"type", "boolean"},
+                    {"default", false},
+                    {"required", false},
+                    {"description", "Encodes the renditions concurrently."}
                 }}
             }}
         });
         //_DOCS: END
         return {"image", schema};
     }
+
+private:
+    void make_renditions(MessageWrapper & msg_w)
+    {
+        auto image = msg_w.view().get_payload_uchar();
+        auto & extra_storage = msg_w.get_extra();
+
+        if( ! parallel_ || rendition_scalers_.size() == 1 )
+        {
+            thread_local cv::Mat decoded;
+            thread_local cv::Mat scratch;
+            ImageScaler::decode(image, rendition_scalers_, decoded);
+            for( size_t ix = 0; ix < rendition_scalers_.size(); ++ix )
+            {
+                uchars encoded;
+                rendition_scalers_[ix].encode(decoded, scratch, encoded);
+                extra_storage.add_extra(rendition_extras_[ix], std::move(encoded));
+            }
+            return;
+        }
+
+        auto job = std::make_shared<ImageRenditionJob>(rendition_scalers_);
+        ImageScaler::decode(image, rendition_scalers_, job->decoded);
+        for( size_t ix = 1; ix < rendition_scalers_.size(); ++ix )
+        {
+            runner_.submit([job, ix]{ job->run(ix); });
+        }
+        for( size_t ix = 0; ix < rendition_scalers_.size(); ++ix )
+        {
+            job->run(ix);
+        }
+        job->wait();
+
+        for( size_t ix = 0; ix < rendition_scalers_.size(); ++ix )
+        {
+            if( job->errors[ix] ) std::rethrow_exception(job->errors[ix]);
+            extra_storage.add_extra(rendition_extras_[ix], std::move(job->results[ix]));
+        }
+    }
 };
 
 
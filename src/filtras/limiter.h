@@ -53,7 +53,7 @@ public:
     }
 
     string process_message(MessageWrapper & msg_w)override{
-        string const & data = msg_w.msg().get_raw();
+        std::string_view data = msg_w.view().get_raw();
         msg_w.pass_if(data.size() <= size_);
         return "";
     }
@@ -69,7 +69,7 @@ public:
     }
 
     string process_message(MessageWrapper & msg_w)override{
-        string const & data = msg_w.msg().get_raw();
+        std::string_view data = msg_w.view().get_raw();
         if(data.size() > chunk_size_){
             msg_w_ = & msg_w;
             chunk_counter_ = 0;
@@ -84,7 +84,7 @@ public:
     Message generate_message()override{
         if(chunk_counter_ == -1) return Message();
         auto j_chunk = json::array();
-        string const & orig_data = msg_w_->msg().get_raw();
+        std::string_view orig_data = msg_w_->view().get_raw();
         auto chunk_start = orig_data.begin() + chunk_size_ * chunk_counter_;
         auto rest = orig_data.end() - chunk_start;
         if(rest <= 0) return Message();
@@ -95,7 +95,7 @@ public:
         j_chunk.push_back(orig_data.size());
         j_chunk.push_back(chunk_counter_++);
         j_chunk.push_back(json::binary(std::move(buffer)));
-        return Message(j_chunk, MessageFormat::Type::CBOR, msg_w_->msg().get_topic());
+        return Message(j_chunk, MessageFormat::Type::CBOR, msg_w_->view().get_topic());
     }
 
     static pair<string, json> get_schema(){
@@ -215,6 +215,9 @@ public:
 
     bool get_api_authentication(){ return config_.value("api_authentication", true); }
 
+    // Threads of the shared executor running pipeline tasks, 0 - one per CPU core
+    unsigned get_executor_threads(){ return config_.value("executor_threads", 0u); }
+
     string const & get_ca_storage(){
         static string ca_storage {"/gnode/storage/ca/"};
         return ca_storage;
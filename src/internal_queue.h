@@ -50,17 +50,21 @@ class InternalQueue;
 
 class RQueue{
     size_t id_ {};
-    TSQueue<std::shared_ptr<Message>> * queue_ {nullptr};
+    TSQueue<std::shared_ptr<Message const>> * queue_ {nullptr};
 public:
     RQueue() = default;
-    RQueue(size_t id, TSQueue<std::shared_ptr<Message>> * queue): id_(id), queue_(queue) {}
+    RQueue(size_t id, TSQueue<std::shared_ptr<Message const>> * queue): id_(id), queue_(queue) {}
 
     RQueue(RQueue const & other): id_(other.id_), queue_(other.queue_) {}
 
-    std::shared_ptr<Message> pop(){
+    std::shared_ptr<Message const> pop(){
         return queue_->pop();
     }
 
+    std::optional<std::shared_ptr<Message const>> try_pop(std::chrono::milliseconds timeout){
+        return queue_->try_pop(timeout);
+    }
+
     void exit_blocking_calls(){
         queue_->set_non_blocking();
     }
@@ -70,7 +74,7 @@ public:
 
 
 class InternalQueue {
-    std::unordered_map<size_t, TSQueue<std::shared_ptr<Message>>> buffers_;
+    std::unordered_map<size_t, TSQueue<std::shared_ptr<Message const>>> buffers_;
     size_t max_taken_key_ {0};
     std::shared_mutex buffers_mtx_;
     static std::map<std::string, InternalQueue> queues_;  // queuid
@@ -92,8 +96,8 @@ public:
         return & queues_[queuid];
     }
 
-    static void redirect(Message const & msg, std::string const & queuid){
-        get_queue(queuid).push(std::make_shared<Message>(msg));
+    static void redirect(std::shared_ptr<Message const> const & msg_ptr, std::string const & queuid){
+        get_queue(queuid).push(msg_ptr);
     }
 
     RQueue subscribe(size_t buffer_size){
@@ -111,7 +115,7 @@ public:
         buffers_.erase(rq.id_);
     }
 
-    void push(std::shared_ptr<Message> const & msg_ptr){
+    void push(std::shared_ptr<Message const> const & msg_ptr){
         std::shared_lock<std::shared_mutex> lock(buffers_mtx_);
         for (auto & [subscriber_id, buffer] : buffers_){
             buffer.push(msg_ptr);
@@ -119,7 +123,7 @@ public:
     }
 
     void push(Message && msg){
-        auto msg_ptr = std::make_shared<Message>(msg);
+        auto msg_ptr = std::make_shared<Message const>(std::move(msg));
         std::shared_lock<std::shared_mutex> lock(buffers_mtx_);
         for (auto & [subscriber_id, buffer] : buffers_){
             buffer.push(msg_ptr);
@@ -63,7 +63,6 @@ using std::time_t;
 using std::byte;
 
 
-typedef pair<string,string> hops_t;
 
 
 template<typename T>
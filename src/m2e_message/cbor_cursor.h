@@ -0,0 +1,345 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_CBOR_CURSOR_H__
+#define __M2E_BRIDGE_CBOR_CURSOR_H__
+
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+class CborValue;
+
+
+/*
+Sorted keys of the large maps of one CBOR document, built on the first lookup of
+each map and shared by all cursors over the document. Maps with few entries are
+scanned instead.
+*/
+class CborIndex{
+public:
+    struct Entry{
+        std::string_view key;
+        size_t value_offset;
+    };
+
+    static constexpr size_t MIN_ENTRIES {16};
+
+    // The document changed, offsets of the indexed maps are stale
+    void clear(){
+        std::lock_guard<std::mutex> lock(mtx_);
+        maps_.clear();
+    }
+
+private:
+    friend class CborValue;
+
+    std::mutex mtx_;
+    std::unordered_map<size_t, std::vector<Entry>> maps_;
+};
+
+
+/*
+A cursor over one item of a CBOR document, reading it in place. Strings are
+returned as views of the document and nothing is allocated, except for the keys
+of large maps in a CborIndex.
+
+Tags are skipped, a tagged item reads as the item itself. Indefinite length
+arrays and maps are supported; indefinite length strings are not contiguous
+and can only be skipped. Malformed or truncated items throw std::runtime_error.
+*/
+class CborValue{
+public:
+    enum class Type{ UINT, NEGINT, BYTES, TEXT, ARRAY, MAP, FALSE, TRUE, NIL, UNDEFINED, SIMPLE, FLOAT };
+
+    CborValue() = default;
+
+    CborValue(std::span<std::byte const> doc, size_t offset = 0, CborIndex * index = nullptr):
+        doc_(doc), offset_(offset), index_(index)
+    {
+        skip_tags();
+    }
+
+    explicit operator bool() const{
+        return offset_ < doc_.size();
+    }
+
+    Type type() const{
+        Head h = head(offset_);
+        switch(h.major){
+            case 0: return Type::UINT;
+            case 1: return Type::NEGINT;
+            case 2: return Type::BYTES;
+            case 3: return Type::TEXT;
+            case 4: return Type::ARRAY;
+            case 5: return Type::MAP;
+            default:
+                switch(h.info){
+                    case 20: return Type::FALSE;
+                    case 21: return Type::TRUE;
+                    case 22: return Type::NIL;
+                    case 23: return Type::UNDEFINED;
+                    case 25: case 26: case 27: return Type::FLOAT;
+                    default: return Type::SIMPLE;
+                }
+        }
+    }
+
+    bool is_int() const{ Type t = type(); return t == Type::UINT || t == Type::NEGINT; }
+    bool is_float() const{ return type() == Type::FLOAT; }
+    bool is_bool() const{ Type t = type(); return t == Type::FALSE || t == Type::TRUE; }
+    bool is_bytes() const{ return type() == Type::BYTES; }
+    bool is_text() const{ return type() == Type::TEXT; }
+    bool is_array() const{ return type() == Type::ARRAY; }
+    bool is_map() const{ return type() == Type::MAP; }
+
+    long long as_int() const{
+        Head h = head(offset_);
+        if(h.major == 0) return static_cast<long long>(h.arg);
+        if(h.major == 1) return -1 - static_cast<long long>(h.arg);
+        throw std::runtime_error("CBOR item is not an integer!");
+    }
+
+    double as_double() const{
+        Head h = head(offset_);
+        if(h.major != 7) throw std::runtime_error("CBOR item is not a float!");
+        switch(h.info){
+            case 25: return half_to_double(static_cast<uint16_t>(h.arg));
+            case 26: return std::bit_cast<float>(static_cast<uint32_t>(h.arg));
+            case 27: return std::bit_cast<double>(h.arg);
+        }
+        throw std::runtime_error("CBOR item is not a float!");
+    }
+
+    bool as_bool() const{
+        Type t = type();
+        if(t == Type::TRUE) return true;
+        if(t == Type::FALSE) return false;
+        throw std::runtime_error("CBOR item is not a boolean!");
+    }
+
+    std::span<std::byte const> bytes() const{
+        Head h = head(offset_);
+        if(h.major != 2 || h.indefinite) throw std::runtime_error("CBOR item is not a definite byte string!");
+        return doc_.subspan(offset_ + h.size, h.arg);
+    }
+
+    std::string_view text() const{
+        Head h = head(offset_);
+        if(h.major != 3 || h.indefinite) throw std::runtime_error("CBOR item is not a definite text string!");
+        return std::string_view(reinterpret_cast<char const *>(doc_.data() + offset_ + h.size), h.arg);
+    }
+
+    // Number of elements of an array or of entries of a map
+    size_t size() const{
+        Head h = head(offset_);
+        if(h.major != 4 && h.major != 5) throw std::runtime_error("CBOR item is not a container!");
+        if(! h.indefinite) return h.arg;
+        size_t n = 0;
+        for(size_t pos = offset_ + h.size; ! is_break(pos); ++n){
+            pos = skip(pos, 0);
+            if(h.major == 5) pos = skip(pos, 0);
+        }
+        return n;
+    }
+
+    std::optional<CborValue> at(size_t ix) const{
+        Head h = head(offset_);
+        if(h.major != 4) throw std::runtime_error("CBOR item is not an array!");
+        size_t pos = offset_ + h.size;
+        for(size_t n = 0; h.indefinite ? ! is_break(pos) : n < h.arg; ++n){
+            if(n == ix) return CborValue(doc_, pos, index_);
+            pos = skip(pos, 0);
+        }
+        return std::nullopt;
+    }
+
+    // The value of a text key of a map, the last one of duplicate keys
+    std::optional<CborValue> find(std::string_view key) const{
+        Head h = head(offset_);
+        if(h.major != 5) throw std::runtime_error("CBOR item is not a map!");
+        if(index_ && ! h.indefinite && h.arg >= CborIndex::MIN_ENTRIES){
+            std::vector<CborIndex::Entry> const & entries = indexed(h);
+            auto it = std::upper_bound(entries.begin(), entries.end(), key,
+                [](std::string_view k, CborIndex::Entry const & e){ return k < e.key; });
+            if(it != entries.begin() && (-- it)->key == key) return CborValue(doc_, it->value_offset, index_);
+            return std::nullopt;
+        }
+        std::optional<CborValue> found;
+        size_t pos = offset_ + h.size;
+        for(size_t n = 0; h.indefinite ? ! is_break(pos) : n < h.arg; ++n){
+            CborValue k(doc_, pos);
+            pos = skip(pos, 0);
+            if(k.is_definite_text() && k.text() == key) found = CborValue(doc_, pos, index_);
+            pos = skip(pos, 0);
+        }
+        return found;
+    }
+
+    // Checks that the item is well-formed and lies within the document
+    void validate() const{
+        skip(offset_, 0);
+    }
+
+    // Offset past the end of the item
+    size_t end() const{
+        return skip(offset_, 0);
+    }
+
+private:
+    static constexpr size_t MAX_DEPTH {256};
+
+    struct Head{
+        uint8_t major;
+        uint8_t info;
+        uint64_t arg;
+        size_t size;
+        bool indefinite;
+    };
+
+    std::span<std::byte const> doc_;
+    size_t offset_ {0};
+    CborIndex * index_ {nullptr};
+
+    [[noreturn]] static void malformed(){
+        throw std::runtime_error("Malformed CBOR payload!");
+    }
+
+    uint8_t byte_at(size_t pos) const{
+        if(pos >= doc_.size()) malformed();
+        return static_cast<uint8_t>(doc_[pos]);
+    }
+
+    bool is_break(size_t pos) const{
+        return byte_at(pos) == 0xFF;
+    }
+
+    Head head(size_t pos) const{
+        uint8_t initial = byte_at(pos);
+        Head h {static_cast<uint8_t>(initial >> 5), static_cast<uint8_t>(initial & 0x1F), 0, 1, false};
+        if(h.info < 24){
+            h.arg = h.info;
+        }else if(h.info <= 27){
+            size_t n = size_t(1) << (h.info - 24);
+            if(pos + 1 + n > doc_.size()) malformed();
+            for(size_t i = 0; i < n; ++i){
+                h.arg = (h.arg << 8) | static_cast<uint8_t>(doc_[pos + 1 + i]);
+            }
+            h.size += n;
+        }else if(h.info == 31 && h.major >= 2 && h.major <= 5){
+            h.indefinite = true;
+        }else{
+            malformed();
+        }
+        return h;
+    }
+
+    bool is_definite_text() const{
+        Head h = head(offset_);
+        return h.major == 3 && ! h.indefinite;
+    }
+
+    void skip_tags(){
+        while(offset_ < doc_.size() && head(offset_).major == 6){
+            offset_ += head(offset_).size;
+        }
+    }
+
+    size_t skip(size_t pos, size_t depth) const{
+        if(depth > MAX_DEPTH) malformed();
+        Head h = head(pos);
+        pos += h.size;
+        switch(h.major){
+            case 2: case 3:
+                if(h.indefinite){
+                    while(! is_break(pos)) pos = skip(pos, depth + 1);
+                    return pos + 1;
+                }
+                if(h.arg > doc_.size() - pos) malformed();
+                return pos + h.arg;
+            case 4: case 5: {
+                uint64_t items = h.major == 5 ? h.arg * 2 : h.arg;
+                if(h.indefinite){
+                    while(! is_break(pos)) pos = skip(pos, depth + 1);
+                    return pos + 1;
+                }
+                // Every item takes a byte at least
+                if(items > doc_.size() - pos) malformed();
+                for(uint64_t i = 0; i < items; ++i) pos = skip(pos, depth + 1);
+                return pos;
+            }
+            case 6:
+                return skip(pos, depth + 1);
+            default:
+                return pos;
+        }
+    }
+
+    std::vector<CborIndex::Entry> const & indexed(Head const & h) const{
+        std::lock_guard<std::mutex> lock(index_->mtx_);
+        auto [it, inserted] = index_->maps_.try_emplace(offset_);
+        if(inserted){
+            auto & entries = it->second;
+            entries.reserve(h.arg);
+            size_t pos = offset_ + h.size;
+            for(uint64_t n = 0; n < h.arg; ++n){
+                CborValue k(doc_, pos);
+                pos = skip(pos, 0);
+                size_t value_offset = pos;
+                pos = skip(pos, 0);
+                if(k.is_definite_text()) entries.push_back({k.text(), value_offset});
+            }
+            // Stable, so the last of duplicate keys is found
+            std::stable_sort(entries.begin(), entries.end(),
+                [](CborIndex::Entry const & a, CborIndex::Entry const & b){ return a.key < b.key; });
+        }
+        return it->second;
+    }
+
+    static double half_to_double(uint16_t half){
+        int exp = (half >> 10) & 0x1F;
+        int mant = half & 0x3FF;
+        double val;
+        if(exp == 0) val = std::ldexp(mant, -24);
+        else if(exp != 31) val = std::ldexp(mant + 1024, exp - 25);
+        else val = mant == 0 ? INFINITY : NAN;
+        return half & 0x8000 ? -val : val;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_CBOR_CURSOR_H__
@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_JSON_SCANNER_H__
+#define __M2E_BRIDGE_JSON_SCANNER_H__
+
+
+#include <cstring>
+#include <string_view>
+
+#include "m2e_aliases.h"
+
+
+/*
+Locates values in JSON text without building a DOM, for filtras which read a
+field or two of a large payload. Values which are not requested are skipped by
+bracket counting, strings by memchr(), which libc vectorizes.
+
+The scanner validates only what it walks over. A malformed document may still
+yield a value found before the defect; everything the scanner can not handle is
+reported as INVALID, and the caller falls back to parsing the whole document.
+*/
+class JsonScanner{
+public:
+    enum class Status{ FOUND, MISSING, INVALID };
+
+    struct Result{
+        Status status;
+        std::string_view value;  // raw JSON text of a found value
+    };
+
+    // The last member named key, nlohmann::json keeps the last of duplicate keys as well
+    static Result find_member(std::string_view doc, std::string_view key){
+        size_t pos = 0;
+        skip_ws(doc, pos);
+        if(pos >= doc.size() || doc[pos] != '{') return {Status::INVALID};
+        ++pos;
+        skip_ws(doc, pos);
+        if(pos < doc.size() && doc[pos] == '}') return {Status::MISSING};
+
+        Result res {Status::MISSING};
+        while(true){
+            skip_ws(doc, pos);
+            size_t key_start = pos;
+            if(pos >= doc.size() || doc[pos] != '"' || ! skip_string(doc, pos)) return {Status::INVALID};
+            std::string_view member_key = doc.substr(key_start, pos - key_start);
+
+            skip_ws(doc, pos);
+            if(pos >= doc.size() || doc[pos] != ':') return {Status::INVALID};
+            ++pos;
+            skip_ws(doc, pos);
+            size_t value_start = pos;
+            if(! skip_value(doc, pos)) return {Status::INVALID};
+
+            if(key_equals(member_key, key)){
+                res = {Status::FOUND, doc.substr(value_start, pos - value_start)};
+            }
+
+            skip_ws(doc, pos);
+            if(pos >= doc.size()) return {Status::INVALID};
+            if(doc[pos] == '}') return res;
+            if(doc[pos] != ',') return {Status::INVALID};
+            ++pos;
+        }
+    }
+
+    static Result find_element(std::string_view doc, size_t ix){
+        size_t pos = 0;
+        skip_ws(doc, pos);
+        if(pos >= doc.size() || doc[pos] != '[') return {Status::INVALID};
+        ++pos;
+        skip_ws(doc, pos);
+        if(pos < doc.size() && doc[pos] == ']') return {Status::MISSING};
+
+        for(size_t n = 0; ; ++n){
+            skip_ws(doc, pos);
+            size_t value_start = pos;
+            if(! skip_value(doc, pos)) return {Status::INVALID};
+            if(n == ix) return {Status::FOUND, doc.substr(value_start, pos - value_start)};
+
+            skip_ws(doc, pos);
+            if(pos >= doc.size()) return {Status::INVALID};
+            if(doc[pos] == ']') return {Status::MISSING};
+            if(doc[pos] != ',') return {Status::INVALID};
+            ++pos;
+        }
+    }
+
+private:
+    static void skip_ws(std::string_view s, size_t & pos){
+        while(pos < s.size() && (s[pos] == ' ' || s[pos] == '\n' || s[pos] == '\r' || s[pos] == '\t')) ++pos;
+    }
+
+    // From the opening quote to past the closing one
+    static bool skip_string(std::string_view s, size_t & pos){
+        size_t from = pos + 1;
+        while(from < s.size()){
+            auto quote = static_cast<char const *>(std::memchr(s.data() + from, '"', s.size() - from));
+            if(! quote) return false;
+            size_t q = quote - s.data();
+            size_t backslashes = 0;
+            while(q - backslashes > pos + 1 && s[q - backslashes - 1] == '\\') ++backslashes;
+            if(backslashes % 2 == 0){
+                pos = q + 1;
+                return true;
+            }
+            from = q + 1;
+        }
+        return false;
+    }
+
+    static bool skip_value(std::string_view s, size_t & pos){
+        if(pos >= s.size()) return false;
+        char c = s[pos];
+        if(c == '"') return skip_string(s, pos);
+        if(c == '{' || c == '['){
+            size_t depth = 0;
+            while(pos < s.size()){
+                pos = s.find_first_of("\"{}[]", pos);
+                if(pos == std::string_view::npos) return false;
+                switch(s[pos]){
+                    case '"':
+                        if(! skip_string(s, pos)) return false;
+                        continue;
+                    case '{': case '[':
+                        ++depth;
+                        break;
+                    default:
+                        if(--depth == 0){
+                            ++pos;
+                            return true;
+                        }
+                }
+                ++pos;
+            }
+            return false;
+        }
+        // Number, true, false or null
+        size_t start = pos;
+        while(pos < s.size() && std::strchr(",}] \n\r\t", s[pos]) == nullptr) ++pos;
+        return pos > start;
+    }
+
+    // Keys with escapes are rare, they are decoded for the comparison
+    static bool key_equals(std::string_view quoted, std::string_view key){
+        std::string_view raw = quoted.substr(1, quoted.size() - 2);
+        if(raw.find('\\') == std::string_view::npos) return raw == key;
+        return json::parse(quoted).get_ref<string const &>() == key;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_JSON_SCANNER_H__
@@ -34,13 +34,20 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define __M2E_BRIDGE_MESSAGE_H__
 
 
+#include <atomic>
 #include <cstddef>
 #include <iostream>
-#include <regex>
-
-#include <cbor.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
 
 #include "m2e_aliases.h"
+#include "cbor_cursor.h"
+#include "json_scanner.h"
+#include "payload_buffer.h"
+#include "topic.h"
 
 
 struct MessageFormat
@@ -77,106 +84,117 @@ using bytes = std::vector<std::byte>;
 using uchars = std::vector<unsigned char>;
 
 
+/*
+A message with its payload in a PayloadBuffer which is never modified in place.
+Copying a message shares the buffer, and the decoded JSON as well, so wrapping a
+received message for a filtra chain costs no payload copies. A modification
+(set_raw(), non-const get_json()) replaces the buffer or detaches the JSON first.
+
+Decoded forms of the payload live in a separate block, allocated
+on the first decoding, so messages which are only forwarded stay small. Const
+getters decode lazily under the mutex of that block, so one message can be read
+by several pipelines at once.
+
+The raw and the decoded JSON forms have separate validity bits. Reading either
+form never invalidates the other, so a payload is parsed and serialized at most
+once between modifications however filtras alternate get_raw() and get_json().
+Only a modification drops the form it makes stale.
+*/
 class Message{
+    struct Decoded{
+        std::mutex mtx;
+        std::shared_ptr<json> json_ptr;
+        CborIndex cbor_index;
+        bool cbor_validated {false};
+
+        void drop_cbor(){
+            cbor_index.clear();
+            cbor_validated = false;
+        }
+    };
+
+    mutable PayloadBuffer msg_raw_;
+    std::shared_ptr<Topic const> topic_;
+    map<string, string> attributes_;
+    mutable std::atomic<Decoded *> decoded_ {nullptr};
+    // Forms of the payload which are up to date, at least one of them
+    enum Form : uint8_t { RAW = 1, DOM = 2 };
+    mutable std::atomic<uint8_t> valid_ {RAW};
     bool is_valid_ {false};
-    bytes payload_bytes_;
-    uchars payload_uchars_;
-    std::string msg_raw_;
-    std::string msg_topic_;
-    mutable json decoded_json_;
-    cbor_item_t *decoded_cbor_ {nullptr};
-    mutable bool is_serialized_ {false};
-    mutable std::vector<std::string> topic_levels_;
-    string empty_level_ {""};
     MessageFormat::Type format_ {MessageFormat::Type::UNKN};
-    map<string, string> attributes_;
+    static inline string const empty_string_ {""};
+    static inline vector<std::string_view> const no_levels_ {};
 public:
     Message() = default;
 
-    Message(string const & data, MessageFormat::Type format, string const & topic = ""){
-        is_serialized_ = true;
-        msg_raw_ = data;
-        msg_topic_ = topic;
-        format_ = format;
-        is_valid_ = true;
-    }
+    Message(string const & data, MessageFormat::Type format, string const & topic = ""):
+        Message(PayloadBuffer(std::string_view(data)), format, topic) {}
 
-    Message(vector<std::byte> const & data, MessageFormat::Type format, string const & topic = ""){
-        is_serialized_ = true;
-        msg_raw_.resize(data.size());
-        for(int ix = 0; ix < data.size(); ++ix){
-            msg_raw_[ix] = static_cast<char>(data[ix]);
-        }
-        msg_topic_ = topic;
-        format_ = format;
-        is_valid_ = true;
-    }
+    Message(string && data, MessageFormat::Type format, string const & topic = ""):
+        Message(PayloadBuffer(std::move(data)), format, topic) {}
 
-    Message(json const & j_data, MessageFormat::Type format, string const & topic = ""){
-        is_serialized_ = false;
-        decoded_json_ = j_data;
-        msg_topic_ = topic;
+    Message(vector<std::byte> const & data, MessageFormat::Type format, string const & topic = ""):
+        Message(PayloadBuffer(std::string_view(reinterpret_cast<char const *>(data.data()), data.size())),
+                format, topic) {}
+
+    Message(char const * data, size_t n, MessageFormat::Type format = MessageFormat::Type::RAW):
+        Message(PayloadBuffer(std::string_view(data, n)), format) {}
+
+    Message(PayloadBuffer && data, MessageFormat::Type format, string const & topic = ""):
+        Message(std::move(data), format, topic.empty() ? nullptr : std::make_shared<Topic const>(topic)) {}
+
+    Message(PayloadBuffer && data, MessageFormat::Type format, std::shared_ptr<Topic const> topic){
+        msg_raw_ = std::move(data);
+        valid_ = RAW;
+        topic_ = std::move(topic);
         format_ = format;
         is_valid_ = true;
     }
 
-    Message(char const * data, size_t n, MessageFormat::Type format = MessageFormat::Type::RAW){
-        is_serialized_ = true;
-        msg_raw_ = string(data, data + n);
+    Message(json const & j_data, MessageFormat::Type format, string const & topic = ""){
+        decoded()->json_ptr = std::make_shared<json>(j_data);
+        valid_ = DOM;
+        if(! topic.empty()) topic_ = std::make_shared<Topic const>(topic);
         format_ = format;
         is_valid_ = true;
     }
 
     Message(Message const & other){
-        msg_raw_ = other.msg_raw_;
-        payload_bytes_ = other.payload_bytes_;
-        payload_uchars_ = other.payload_uchars_;
-        topic_levels_ = other.topic_levels_;
-        is_serialized_ = other.is_serialized_;
-        decoded_json_ = other.decoded_json_;
-        attributes_ = other.attributes_;
-        msg_topic_ = other.msg_topic_;
-        format_ = other.format_;
-        is_valid_ = other.is_valid_;
+        * this = other;
     }
 
     Message & operator=(Message const & other){
         if(this != & other){
+            drop_decoded();
+            Decoded * other_decoded = other.decoded_.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> lock;
+            if(other_decoded){
+                lock = std::unique_lock<std::mutex>(other_decoded->mtx);
+                // CBOR offsets are indexed again by the copy
+                Decoded * own = decoded();
+                own->json_ptr = other_decoded->json_ptr;
+            }
             msg_raw_ = other.msg_raw_;
-            payload_bytes_ = other.payload_bytes_;
-            payload_uchars_ = other.payload_uchars_;
-            topic_levels_ = other.topic_levels_;
-            is_serialized_ = other.is_serialized_;
-            decoded_json_ = other.decoded_json_;
+            valid_ = other.valid_.load();
             attributes_ = other.attributes_;
-            msg_topic_ = other.msg_topic_;
+            topic_ = other.topic_;
             format_ = other.format_;
             is_valid_ = other.is_valid_;
         }
         return * this;
     }
 
-    Message(Message && other)noexcept:
-        msg_raw_(std::move(other.msg_raw_)),
-        payload_bytes_(std::move(other.payload_bytes_)),
-        payload_uchars_(std::move(other.payload_uchars_)),
-        topic_levels_(std::move(other.topic_levels_)),
-        is_serialized_(other.is_serialized_),
-        decoded_json_(std::move(other.decoded_json_)),
-        msg_topic_(std::move(other.msg_topic_)),
-        attributes_(std::move(other.attributes_)),
-        format_(other.format_),
-        is_valid_(other.is_valid_) {}
+    Message(Message && other)noexcept{
+        * this = std::move(other);
+    }
 
     Message & operator=(Message && other)noexcept{
         if(this != & other){
+            drop_decoded();
+            decoded_ = other.decoded_.exchange(nullptr);
             msg_raw_ = std::move(other.msg_raw_);
-            payload_bytes_= std::move(other.payload_bytes_);
-            payload_uchars_= std::move(other.payload_uchars_);
-            topic_levels_ = std::move(other.topic_levels_);
-            is_serialized_ = other.is_serialized_;
-            decoded_json_ = std::move(other.decoded_json_);
-            msg_topic_ = std::move(other.msg_topic_);
+            valid_ = other.valid_.load();
+            topic_ = std::move(other.topic_);
             attributes_ = std::move(other.attributes_);
             format_ = other.format_;
             is_valid_ = other.is_valid_;
@@ -186,12 +204,10 @@ public:
 
     ~Message()
     {
-        if(decoded_cbor_){
-            cbor_decref(&decoded_cbor_);
-        }
+        drop_decoded();
     }
 
-    MessageFormat::Type get_format()
+    MessageFormat::Type get_format() const
     {
         return format_;
     }
@@ -202,98 +218,185 @@ public:
         attributes_ = attrs;
     }
 
-    map<string, string> const & get_attributes(){
+    map<string, string> const & get_attributes() const{
         return attributes_;
     }
 
-    std::string & get_raw(){
-        if(! is_serialized_){
-            if(format_ == MessageFormat::Type::JSON){
-                msg_raw_ = decoded_json_.dump();
-            }else if(format_ == MessageFormat::Type::CBOR){
-                vector<uint8_t> v = json::to_cbor(decoded_json_);
-                msg_raw_ = string(v.begin(), v.end());
-            }else{
-                throw std::runtime_error("Unknown message format");
+    std::string_view get_raw() const{
+        if(! (valid_.load(std::memory_order_acquire) & RAW)){
+            Decoded * d = decoded();
+            std::lock_guard<std::mutex> lock(d->mtx);
+            if(! (valid_.load(std::memory_order_relaxed) & RAW)){
+                msg_raw_ = PayloadBuffer(serialize(d));
+                valid_.fetch_or(RAW, std::memory_order_release);
             }
-            is_serialized_ = true;
         }
+        return msg_raw_.view();
+    }
 
+    PayloadBuffer const & get_payload() const{
+        get_raw();
         return msg_raw_;
     }
 
+    void set_raw(std::string && raw){
+        set_payload(PayloadBuffer(std::move(raw)));
+    }
+
+    void set_raw(std::string_view raw){
+        set_payload(PayloadBuffer(raw));
+    }
+
+    void set_raw(char const * raw){
+        set_payload(PayloadBuffer(std::string_view(raw)));
+    }
+
+    void set_payload(PayloadBuffer && payload){
+        msg_raw_ = std::move(payload);
+        valid_ = RAW;
+        if(Decoded * d = decoded_.load(std::memory_order_acquire)){
+            d->json_ptr.reset();
+            d->drop_cbor();
+        }
+    }
+
+    json const & get_json() const{
+        Decoded * d = decoded();
+        std::lock_guard<std::mutex> lock(d->mtx);
+        return decode_json(d);
+    }
+
+    // Raw JSON text of a JSON payload, unless it is decoded already or modified as JSON;
+    // reading a few values from the text is then cheaper than decoding it
+    std::optional<std::string_view> get_json_text() const{
+        if(format_ != MessageFormat::Type::JSON) return std::nullopt;
+        if(valid_.load(std::memory_order_acquire) != RAW) return std::nullopt;
+        return msg_raw_.view();
+    }
+
+    // A top-level member of a JSON payload, only the member is parsed unless the payload is decoded
+    std::optional<json> get_json_member(std::string_view key) const{
+        if(auto text = get_json_text()){
+            auto res = JsonScanner::find_member(* text, key);
+            if(res.status == JsonScanner::Status::FOUND) return json::parse(res.value);
+            if(res.status == JsonScanner::Status::MISSING) return std::nullopt;
+        }
+        json const & j = get_json();
+        if(! j.is_object()) return std::nullopt;
+        auto it = j.find(key);
+        if(it == j.end()) return std::nullopt;
+        return * it;
+    }
+
+    bool has_json_member(std::string_view key) const{
+        if(auto text = get_json_text()){
+            auto res = JsonScanner::find_member(* text, key);
+            if(res.status != JsonScanner::Status::INVALID) return res.status == JsonScanner::Status::FOUND;
+        }
+        return get_json().contains(key);
+    }
+
+    // The payload is going to be modified, later get_raw() serializes it again.
+    // Only reading through this overload costs a needless serialization, read through a const Message.
     json & get_json(){
-        if(is_serialized_){
-           decoded_json_ = json::parse(msg_raw_);
-           is_serialized_ = false;
-           format_ = MessageFormat::Type::JSON;
+        Decoded * d = decoded();
+        std::lock_guard<std::mutex> lock(d->mtx);
+        decode_json(d);
+        if(d->json_ptr.use_count() > 1){
+            d->json_ptr = std::make_shared<json>(* d->json_ptr);
         }
-        return decoded_json_;
+        valid_.store(DOM, std::memory_order_release);
+        if(format_ != MessageFormat::Type::CBOR) format_ = MessageFormat::Type::JSON;
+        d->drop_cbor();
+        return * d->json_ptr;
     }
 
-    cbor_item_t * get_cbor()
+    // A cursor reading the CBOR payload in place, valid while the payload is not modified
+    CborValue get_cbor() const
     {
-        if(is_serialized_){
-            if(decoded_cbor_){ cbor_decref(&decoded_cbor_); }
-            cbor_load_result res;
-            decoded_cbor_ = cbor_load(
-                reinterpret_cast<cbor_data>(msg_raw_.data()),
-                msg_raw_.size(),
-                &res
-            );
-            if(res.error.code != CBOR_ERR_NONE){
+        std::span<std::byte const> raw = get_payload().bytes();
+        Decoded * d = decoded();
+        std::lock_guard<std::mutex> lock(d->mtx);
+        if(! d->cbor_validated){
+            try{
+                CborValue(raw).validate();
+            }catch(std::runtime_error const &){
                 throw std::runtime_error("Can not deserialize CBOR payload!");
             }
-            is_serialized_ = false;
+            d->cbor_validated = true;
         }
-        return decoded_cbor_;
+        return CborValue(raw, 0, & d->cbor_index);
     }
 
-    bytes & get_payload_byte()
+    std::span<std::byte const> get_payload_byte() const
     {
-        if( payload_bytes_.size() != msg_raw_.size() )
-        {
-            payload_bytes_.assign(
-                reinterpret_cast<std::byte const*>(msg_raw_.data()),
-                reinterpret_cast<std::byte const*>(msg_raw_.data() + msg_raw_.size())
-            );
-        }
-
-        return payload_bytes_;
+        return get_payload().bytes();
     }
 
-    uchars & get_payload_uchar()
+    std::span<unsigned char const> get_payload_uchar() const
     {
-        if( payload_uchars_.size() != msg_raw_.size() )
-        {
-            payload_uchars_.assign(
-                reinterpret_cast<unsigned char const*>(msg_raw_.data()),
-                reinterpret_cast<unsigned char const*>(msg_raw_.data() + msg_raw_.size())
-            );
-        }
+        return get_payload().uchars();
+    }
 
-        return payload_uchars_;
+    std::string_view get_topic_level(size_t level) const{
+        return find_topic_level(level).value_or(std::string_view());
     }
 
-    std::string const & get_topic_level(int level){
-        using namespace std;
-        auto & levels = get_topic_levels();
-        return level < levels.size() ? levels[level] : empty_level_;
+    std::optional<std::string_view> find_topic_level(size_t level) const{
+        return topic_ ? topic_->level(level) : std::nullopt;
     }
 
-    std::vector<std::string> const & get_topic_levels(){
-        using namespace std;
-        if(topic_levels_.size() == 0){
-            regex r("/");
-            sregex_token_iterator it(msg_topic_.begin(), msg_topic_.end(), r, -1);
-            sregex_token_iterator end;
-            topic_levels_ = vector<std::string>(it, end);
-        }
-        return topic_levels_;
+    std::vector<std::string_view> const & get_topic_levels() const{
+        return topic_ ? topic_->levels() : no_levels_;
     }
 
     std::string const & get_topic()const{
-        return msg_topic_;
+        return topic_ ? topic_->str() : empty_string_;
+    }
+
+    std::shared_ptr<Topic const> const & get_topic_ptr() const{
+        return topic_;
+    }
+
+private:
+    Decoded * decoded() const{
+        Decoded * d = decoded_.load(std::memory_order_acquire);
+        if(! d){
+            auto fresh = new Decoded();
+            if(decoded_.compare_exchange_strong(d, fresh, std::memory_order_acq_rel)){
+                d = fresh;
+            }else{
+                delete fresh;  // another reader was faster
+            }
+        }
+        return d;
+    }
+
+    void drop_decoded(){
+        delete decoded_.exchange(nullptr);
+    }
+
+    std::string serialize(Decoded * d) const{
+        if(! d->json_ptr){
+            return "";
+        }else if(format_ == MessageFormat::Type::JSON){
+            return d->json_ptr->dump();
+        }else if(format_ == MessageFormat::Type::CBOR){
+            vector<uint8_t> v = json::to_cbor(* d->json_ptr);
+            return string(v.begin(), v.end());
+        }
+        throw std::runtime_error("Unknown message format");
+    }
+
+    json & decode_json(Decoded * d) const{
+        if(! d->json_ptr){
+            std::string_view raw = msg_raw_.view();
+            d->json_ptr = std::make_shared<json>(
+                format_ == MessageFormat::Type::CBOR ? json::from_cbor(raw) : json::parse(raw)
+            );
+            valid_.fetch_or(DOM, std::memory_order_release);
+        }
+        return * d->json_ptr;
     }
 };
 
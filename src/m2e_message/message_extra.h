@@ -49,7 +49,7 @@ public:
         // Since we return the pointer to an extra in get_extra, we must be careful
         // with adding extras more than once...
         if( ! extras_.contains(key) ){
-            extras_[key] = data;
+            extras_[key] = std::forward<T>(data);
         }
         else{
             throw std::logic_error("Extra already exist!");
@@ -41,7 +41,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 class MetaMessage{
-    std::shared_ptr<Message> orig_;
+    std::shared_ptr<Message const> orig_;
     std::shared_ptr<Message> alt_;
     bool is_initialized_ {false};
     bool is_passed_ {false};
@@ -50,9 +50,8 @@ class MetaMessage{
 public:
     MetaMessage() = default;
 
-    MetaMessage(std::shared_ptr<Message> msg_ptr){
+    MetaMessage(std::shared_ptr<Message const> msg_ptr){
         orig_ = msg_ptr;
-        alt_ = std::make_shared<Message>();
         is_initialized_ = true;
         is_passed_ = true;
         metadata_ = json();
@@ -60,18 +59,28 @@ public:
 
     Message const & orig()const{return * orig_.get();}
 
-    Message & msg(){
-        if(! * alt_){
-            alt_ = std::make_shared<Message>(* orig_.get());
+    // The current message, read-only access does not copy it
+    Message const & view()const{return alt_ ? * alt_ : * orig_;}
+
+    // The current message, copied on the first modification. The copy shares
+    // the payload buffer with the original until one of them changes it.
+    Message & mut(){
+        if(! alt_){
+            alt_ = std::make_shared<Message>(* orig_);
         }
-        return * alt_.get();
+        return * alt_;
     }
 
     void set_message(Message && msg){
-        alt_ = std::make_shared<Message>(msg);
+        alt_ = std::make_shared<Message>(std::move(msg));
     }
 
-    std::shared_ptr<Message> msg_ptr(){return alt_;}
+    // The current message to be shared with others, e.g. pushed to internal queues.
+    // It becomes the original, so it is copied again before the next modification.
+    std::shared_ptr<Message const> msg_ptr(){
+        if(alt_) orig_ = std::move(alt_);
+        return orig_;
+    }
     explicit operator bool()const{return is_initialized_;}
     bool is_passed(){return is_passed_;}
     void pass(){is_passed_ = true;}
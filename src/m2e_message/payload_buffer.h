@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_PAYLOAD_BUFFER_H__
+#define __M2E_BRIDGE_PAYLOAD_BUFFER_H__
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+/*
+Immutable message payload, viewed as chars, bytes or unsigned chars without copying.
+
+Payloads up to INLINE_CAPACITY bytes, typical for sensor telemetry, are stored in
+place and copied with the buffer. Larger ones live in a refcounted string shared
+by all copies; a string passed by rvalue is adopted without copying its bytes.
+*/
+
+class alignas(8) PayloadBuffer
+{
+public:
+    static constexpr size_t INLINE_CAPACITY = 63;
+
+private:
+    using Heap = std::shared_ptr<std::string const>;
+    static constexpr uint8_t ON_HEAP = 0xFF;
+    static_assert(sizeof(Heap) <= INLINE_CAPACITY);
+
+    // Inline bytes, or a Heap constructed in place when tag_ is ON_HEAP
+    char storage_[INLINE_CAPACITY];
+    uint8_t tag_ {0};  // inline size or ON_HEAP
+
+public:
+    PayloadBuffer() = default;
+
+    explicit PayloadBuffer(std::string_view data)
+    {
+        if( data.size() <= INLINE_CAPACITY ){
+            store_inline(data);
+        }else{
+            store_heap(std::make_shared<std::string const>(data));
+        }
+    }
+
+    explicit PayloadBuffer(std::string && data)
+    {
+        if( data.size() <= INLINE_CAPACITY ){
+            store_inline(data);
+        }else{
+            store_heap(std::make_shared<std::string const>(std::move(data)));
+        }
+    }
+
+    PayloadBuffer(PayloadBuffer const & other)
+    {
+        copy_from(other);
+    }
+
+    PayloadBuffer(PayloadBuffer && other) noexcept
+    {
+        move_from(other);
+    }
+
+    PayloadBuffer & operator=(PayloadBuffer const & other)
+    {
+        if( this != & other ){
+            reset();
+            copy_from(other);
+        }
+        return * this;
+    }
+
+    PayloadBuffer & operator=(PayloadBuffer && other) noexcept
+    {
+        if( this != & other ){
+            reset();
+            move_from(other);
+        }
+        return * this;
+    }
+
+    ~PayloadBuffer()
+    {
+        reset();
+    }
+
+    bool is_inline() const { return tag_ != ON_HEAP; }
+
+    size_t size() const
+    {
+        return is_inline() ? tag_ : heap()->size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    char const * data() const
+    {
+        return is_inline() ? storage_ : heap()->data();
+    }
+
+    std::string_view view() const { return {data(), size()}; }
+
+    std::span<std::byte const> bytes() const
+    {
+        return {reinterpret_cast<std::byte const *>(data()), size()};
+    }
+
+    std::span<unsigned char const> uchars() const
+    {
+        return {reinterpret_cast<unsigned char const *>(data()), size()};
+    }
+
+    // Shares the bytes with `other`, inline payloads are never shared
+    bool shares(PayloadBuffer const & other) const
+    {
+        return ! is_inline() && ! other.is_inline() && heap()->data() == other.heap()->data();
+    }
+
+private:
+    Heap * heap_ptr() { return std::launder(reinterpret_cast<Heap *>(storage_)); }
+    Heap const * heap_ptr() const { return std::launder(reinterpret_cast<Heap const *>(storage_)); }
+    Heap const & heap() const { return * heap_ptr(); }
+
+    void store_inline(std::string_view data)
+    {
+        std::memcpy(storage_, data.data(), data.size());
+        tag_ = static_cast<uint8_t>(data.size());
+    }
+
+    void store_heap(Heap && heap)
+    {
+        new (storage_) Heap(std::move(heap));
+        tag_ = ON_HEAP;
+    }
+
+    void copy_from(PayloadBuffer const & other)
+    {
+        if( other.is_inline() ){
+            store_inline(other.view());
+        }else{
+            store_heap(Heap(other.heap()));
+        }
+    }
+
+    void move_from(PayloadBuffer & other)
+    {
+        if( other.is_inline() ){
+            store_inline(other.view());
+        }else{
+            store_heap(std::move(* other.heap_ptr()));
+            other.reset();
+        }
+    }
+
+    void reset()
+    {
+        if( ! is_inline() ){
+            heap_ptr()->~Heap();
+        }
+        tag_ = 0;
+    }
+};
+
+
+static_assert(sizeof(PayloadBuffer) == PayloadBuffer::INLINE_CAPACITY + 1);
+
+
+#endif  // __M2E_BRIDGE_PAYLOAD_BUFFER_H__
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_TOPIC_H__
+#define __M2E_BRIDGE_TOPIC_H__
+
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+/*
+Immutable topic string, shared by all copies of a message.
+
+Levels are string_view slices of the topic, split on '/' once on the first
+levels() call. A single level is found by scanning up to it, so substituting
+TOPIC_LEVELS[n] does not split the whole topic. As with the former regex
+tokenizer, an empty topic has no levels and a trailing '/' adds no empty level.
+*/
+class Topic{
+    std::string str_;
+    mutable std::once_flag split_once_;
+    mutable std::vector<std::string_view> levels_;
+public:
+    explicit Topic(std::string str): str_(std::move(str)) {}
+
+    Topic(Topic const &) = delete;
+    Topic & operator=(Topic const &) = delete;
+
+    std::string const & str() const{
+        return str_;
+    }
+
+    std::optional<std::string_view> level(size_t ix) const{
+        std::string_view topic(str_);
+        size_t start = 0;
+        for(; ix > 0; --ix){
+            size_t pos = topic.find('/', start);
+            if(pos == std::string_view::npos) return std::nullopt;
+            start = pos + 1;
+        }
+        if(start >= topic.size()) return std::nullopt;
+        size_t end = topic.find('/', start);
+        return topic.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    }
+
+    std::vector<std::string_view> const & levels() const{
+        std::call_once(split_once_, [this]{
+            std::string_view topic(str_);
+            size_t start = 0;
+            while(start < topic.size()){
+                size_t end = topic.find('/', start);
+                if(end == std::string_view::npos) end = topic.size();
+                levels_.push_back(topic.substr(start, end - start));
+                start = end + 1;
+            }
+        });
+        return levels_;
+    }
+};
+
+
+/*
+Recently seen topics of one receiver, so messages arriving on the same topic
+share one Topic and split it once. Not thread safe, each receiver owns its cache.
+*/
+class TopicCache{
+    static constexpr size_t CAPACITY {256};
+    std::unordered_map<std::string_view, std::shared_ptr<Topic const>> topics_;
+public:
+    std::shared_ptr<Topic const> intern(std::string const & topic){
+        if(topic.empty()) return nullptr;
+        auto it = topics_.find(topic);
+        if(it != topics_.end()) return it->second;
+        // Wildcard subscriptions may bring unbounded topic sets, start over
+        if(topics_.size() >= CAPACITY) topics_.clear();
+        auto interned = std::make_shared<Topic const>(topic);
+        topics_.emplace(interned->str(), interned);
+        return interned;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_TOPIC_H__
@@ -90,6 +90,8 @@ int main(int argc, char* argv[])
     }
 #endif
 
+    Executor::configure(gc.get_executor_threads());
+
     PipelineSupervisor *ps = PipelineSupervisor::get_instance();
     ps->start_all();
 
@@ -27,7 +27,9 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_MODIFIER_H__
 
 
+#include <map>
 #include <memory>
+#include <mutex>
 
 #include "m2e_aliases.h"
 #include "modifier_internal.h"
@@ -79,7 +81,28 @@ public:
             modifier_ptr_ = std::make_unique<ResizeModifier>(mparams);
             break;
 #endif
+        default:
+            break;
+        }
+        if( ! modifier_ptr_ )
+        {
+            throw std::invalid_argument("Unsupported modifier: " + notation);
+        }
+    }
+
+    // Modifiers keep no state between calls, one instance serves every user of a notation
+    static std::shared_ptr<Modifier> get( string const & notation )
+    {
+        static std::mutex mtx;
+        static std::map<string, std::shared_ptr<Modifier>> modifiers;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto & modifier = modifiers[notation];
+        if( ! modifier )
+        {
+            modifier = std::make_shared<Modifier>(notation);
         }
+        return modifier;
     }
 
     virtual ~Modifier() {}
@@ -27,42 +27,34 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_RESIZE_MODIFIER_H__
 
 
-#include <opencv2/opencv.hpp>
-#include <opencv2/imgcodecs.hpp>
-
 #include "m2e_aliases.h"
 #include "modifier_internal.h"
+#include "utils/image_scaler.h"
 
 
+// Notation: resize,<width>[,<height>]; without a height the aspect ratio is kept
 class ResizeModifier: public ModifierInternal
 {
-    int width_;
+    ImageScaler scaler_;
+
+    static ImageScaler parse(string const & params)
+    {
+        size_t comma = params.find(',');
+        int width = std::stoi(params.substr(0, comma));
+        int height = comma == string::npos ? 0 : std::stoi(params.substr(comma + 1));
+        return ImageScaler(width, height);
+    }
 
 public:
     ResizeModifier( string const & params )
-        :ModifierInternal(params)
+        :ModifierInternal(params), scaler_(parse(params))
     {
-        width_ = std::stoi(params);
     }
 
     uchars modify( std::span<std::byte const> data ) override
     {
-        // Load the image
-        cv::_InputArray input { reinterpret_cast<uchar const *>( data.data() ), static_cast<int>(data.size()) };
-        auto original = cv::imdecode( input, cv::IMREAD_COLOR);
-
-        double ratio = static_cast<double>(width_) / original.cols;
-        int height = static_cast<int>(original.rows * ratio);
-        cv::Size new_size(width_, height);  // width x height
-        cv::Mat resized;
-        cv::resize(original, resized, new_size, 0, 0, cv::INTER_LINEAR);
-
-        vector<int> params = { cv::IMWRITE_JPEG_QUALITY, 90 };
-
-        uchars payload;
-        cv::imencode(".jpeg", resized, payload, params);
-
-        return payload;
+        // A copy of exactly the encoded size, the scaler keeps its buffer
+        return scaler_.resize({reinterpret_cast<unsigned char const *>(data.data()), data.size()});
     }
 
     static json get_schema()
@@ -30,6 +30,7 @@ IN THE SOFTWARE.
 #include "global_state.h"
 #include "pipeline.h"
 #include "internal_queue.h"
+#include "substitutions/subs.hpp"
 #include "factories/filtra_factory.h"
 #include "factories/connector_factory.h"
 
@@ -44,19 +45,53 @@ Pipeline::Pipeline(std::string const & pipeid, json const & pjson){
 Pipeline::~Pipeline(){
     if(state_ != PipelineState::MALFORMED){
         terminate();
-        control_thread_->join();
-        delete control_thread_;
-        control_thread_ = nullptr;
     }
+    control_task_.wait_idle();
 }
 
 
+PipelineWorker::PipelineWorker(Pipeline * pipeline)
+    :pipeline(pipeline),
+     task(Executor::get_instance(), [this]{ this->pipeline->run_processing(* this); }) {}
+
+
 bool Pipeline::construct(json const & pjson){
     last_error_ = "";
     bool success = true;
     // Enabled
     is_enabled_ = pjson.value("enabled", false);
 
+    // Workers and queues
+    unsigned workers = 1;
+    try{
+        queue_config_ = QueueConfig::from_json(pjson.value("queue", json::object()));
+        batch_config_ = BatchConfig::from_json(pjson.value("batch", json::object()));
+        workers = pjson.value("workers", 1u);
+        partition_key_ = CompiledTemplate(pjson.value("partition_key", "{{MSG.TOPIC}}"));
+        routes_ = RoutingGraph::from_json(pjson.value("filtras", json::array()));
+        routes_.bind_queues();
+        if(queue_config_.overflow == OverflowPolicy::Type::DLQ){
+            dlq_ = InternalQueue::get_queue_ptr(queue_config_.dlq);
+        }
+    }catch(std::exception const & e){
+        last_error_ = e.what();
+        return false;
+    }
+    if(workers == 0 || workers > MAX_WORKERS){
+        last_error_ = fmt::format("Workers must be from 1 to {}", MAX_WORKERS);
+        return false;
+    }
+    for(unsigned ix = 0; ix < workers; ++ix){
+        auto worker = std::make_unique<PipelineWorker>(this);
+        worker->r_queue = std::make_unique<SPSCQueue<std::shared_ptr<Message const>>>(
+            queue_config_.capacity, true, queue_config_.capacity_bytes
+        );
+        worker->s_queue = std::make_unique<SPSCQueue<MessageWrapper>>(
+            queue_config_.capacity, true, queue_config_.capacity_bytes
+        );
+        workers_.push_back(std::move(worker));
+    }
+
     // Create connector IN
     try{
         connector_in_ = ConnectorFactory::create(
@@ -67,12 +102,14 @@ bool Pipeline::construct(json const & pjson){
         return false;
     }
 
-    // Create filtras
+    // Create filtras, each worker gets its own chain
     if(pjson.contains("filtras")){
         try{
-            for(auto filtra_parsed : pjson["filtras"]){
-                Filtra * filtra = FiltraFactory::create(* this, filtra_parsed);
-                filtras_.push_back(filtra);
+            for(auto & worker : workers_){
+                for(auto filtra_parsed : pjson["filtras"]){
+                    Filtra * filtra = FiltraFactory::create(* worker, filtra_parsed);
+                    worker->filtras.push_back(filtra);
+                }
             }
         }catch(std::exception const & e){
             last_error_ = e.what();
@@ -98,7 +135,6 @@ bool Pipeline::construct(json const & pjson){
     bool success = construct(config_);
     if(success){
         state_ = PipelineState::STOPPED;
-        control_thread_ = new std::thread(& Pipeline::run_control, this);
     }else{
         state_ = PipelineState::MALFORMED;
         free_resources();  // perform cleaning
@@ -108,6 +144,14 @@ bool Pipeline::construct(json const & pjson){
 
 
 void Pipeline::free_resources(){
+    // No timer may schedule a task from now on, then let the tasks finish
+    timers_.close();
+    for(auto & worker : workers_){
+        worker->task.wait_idle();
+    }
+    sending_task_.wait_idle();
+    out_batch_.clear();
+
     if(connector_in_){
         delete connector_in_;
         connector_in_ = nullptr;
@@ -116,72 +160,64 @@ void Pipeline::free_resources(){
         delete connector_out_;
         connector_out_ = nullptr;
     }
-    for(Filtra * filtra : filtras_){
-        delete filtra;
+    for(auto & worker : workers_){
+        for(Filtra * filtra : worker->filtras){
+            delete filtra;
+        }
     }
-    filtras_.clear();
+    workers_.clear();
 }
 
 
-int Pipeline::find_filtra_index(string const & filtra_name){
-
-    if(filtra_name == "out") return filtras_.size();
-
-    for(int ix = 0; ix < filtras_.size(); ++ix){
-        if(filtras_[ix]->get_name() == filtra_name){
-            return ix;
-        }
+void Pipeline::redirect(FiltraRoute const & route, MessageWrapper & msg_w){
+    if(route.queues.empty()) return;
+    auto msg_ptr = msg_w.msg_ptr();
+    for(auto queue : route.queues){
+        queue->push(msg_ptr);
     }
-    return filtras_.size();
 }
 
 
-void Pipeline::process(){
+void Pipeline::process(PipelineWorker & worker){
+    auto const & filtras = worker.filtras;
     bool is_passed = true;
     int filtra_ix = 0;
     Message msg;
-    while(filtra_ix < filtras_.size()){
-        auto msg = filtras_[filtra_ix]->process();
+    while(filtra_ix < filtras.size()){
+        auto msg = filtras[filtra_ix]->process();
         if(msg) break;
         ++filtra_ix;
     }
     if(msg){
-        std::shared_ptr<Message> msg_ptr = std::make_shared<Message>(std::move(msg));
+        std::shared_ptr<Message const> msg_ptr = std::make_shared<Message>(std::move(msg));
         MessageWrapper msg_w(msg_ptr);
-        if(msg_w.is_passed()){
-            for(auto const & queuid : filtras_[filtra_ix]->get_destinations()){
-                InternalQueue::redirect(msg_w.msg(), queuid);
-            }
-        }
+        if(msg_w.is_passed()) redirect(routes_[filtra_ix], msg_w);
         ++filtra_ix;
-        for(; msg_w.is_passed() && filtra_ix < filtras_.size(); filtra_ix++){
+        for(; msg_w.is_passed() && filtra_ix < filtras.size(); filtra_ix++){
             try{
-                filtras_[filtra_ix]->process(msg_w);
+                filtras[filtra_ix]->process(msg_w);
             }catch(std::exception const & e){
                 last_error_ = e.what();
                 return;
             }
-            if(msg_w.is_passed()){
-                for(auto const & queuid : filtras_[filtra_ix]->get_destinations()){
-                    InternalQueue::redirect(msg_w.msg(), queuid);
-                }
-            }
+            if(msg_w.is_passed()) redirect(routes_[filtra_ix], msg_w);
         }
-        if(msg_w.is_passed()) s_queue_.push(msg_w);
+        if(msg_w.is_passed()) forward(worker, std::move(msg_w));
     }
 }
 
 
-void Pipeline::process(std::shared_ptr<Message> const & msg_ptr, int filtra_ix){
+void Pipeline::process(PipelineWorker & worker, std::shared_ptr<Message const> const & msg_ptr, int filtra_ix){
     MessageWrapper msg_w(msg_ptr);
-    while(filtra_ix < filtras_.size() && is_active()){
-        Filtra * filtra = nullptr;
-        try{
-            filtra = filtras_.at(filtra_ix);
-        }catch(std::out_of_range){
-            msg_w.reject();
-            break;
-        }
+    process(worker, msg_w, filtra_ix);
+}
+
+
+void Pipeline::process(PipelineWorker & worker, MessageWrapper & msg_w, int filtra_ix){
+    auto const & filtras = worker.filtras;
+    while(filtra_ix < filtras.size() && is_active()){
+        Filtra * filtra = filtras[filtra_ix];
+        FiltraRoute const & route = routes_[filtra_ix];
 
         string hop;
         try{
@@ -195,64 +231,249 @@ void Pipeline::process(std::shared_ptr<Message> const & msg_ptr, int filtra_ix){
         }
 
         if(hop == "self"){
-            hops_t hops = filtra->get_hops();
-            if(! hops.first.empty()){
-                filtra_ix = find_filtra_index(hops.first);
-            }else{
-                ++filtra_ix;
-            }
             Message new_msg = filtra->process();
             while(new_msg){
-                process(std::make_shared<Message>(new_msg), filtra_ix);
+                process(worker, std::make_shared<Message>(std::move(new_msg)), route.passed);
                 new_msg = filtra->process();
             }
             return;
         }
 
-        std::pair<string, string> hops = filtra->get_hops();
         if(msg_w.is_passed()){
-            if(! hops.first.empty()){
-                filtra_ix = find_filtra_index(hops.first);
-            }else{
-                filtra_ix++;
-            }
-            for(auto const & queuid : filtra->get_destinations()){
-                InternalQueue::redirect(msg_w.msg(), queuid);
-            }
+            filtra_ix = route.passed;
+            redirect(route, msg_w);
+        }else if(route.rejected != FiltraRoute::DROP){
+            filtra_ix = route.rejected;
+            msg_w.pass(); // let message to flow forward
         }else{
-            if(! hops.second.empty()){
-                filtra_ix = find_filtra_index(hops.second);
-                msg_w.pass(); // let message to flow forward
+            break;
+        }
+    }
+    if(msg_w.is_passed()) forward(worker, std::move(msg_w));
+}
+
+
+void Pipeline::forward(PipelineWorker & worker, MessageWrapper && msg_w){
+    if(worker.backlog.empty() && enqueue(* worker.s_queue, msg_w, false)){
+        sending_task_.schedule();
+    }else{
+        // s_queue is full and the policy is "block", keep the order
+        worker.backlog.push_back(std::move(msg_w));
+    }
+}
+
+
+bool Pipeline::flush_backlog(PipelineWorker & worker){
+    while(! worker.backlog.empty()){
+        if(! offer(* worker.s_queue, worker.backlog.front())){
+            worker.stalled.store(true);
+            // The sending task may have made room before it could see the flag
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(! offer(* worker.s_queue, worker.backlog.front())) return false;
+        }
+        worker.backlog.pop_front();
+        sending_task_.schedule();
+    }
+    return true;
+}
+
+
+size_t Pipeline::partition(Message const & msg){
+    if(workers_.size() < 2) return 0;
+    try{
+        // The key may point into the engine, keep it until the key is hashed
+        auto se = SubsEngine(msg, json(), StringMap());
+        auto key = se.substitute(partition_key_);
+        size_t hash = std::visit([](auto const & v) -> size_t {
+            using V = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<V, json>){
+                return std::hash<string>{}(v.dump());
+            }else if constexpr (std::is_same_v<V, std::span<const std::byte>>
+                    || std::is_same_v<V, std::vector<unsigned char>>){
+                return std::hash<std::string_view>{}(std::string_view(
+                    reinterpret_cast<char const *>(v.data()), v.size()));
             }else{
-                break;
+                return std::hash<V>{}(v);
             }
+        }, key);
+        return hash % workers_.size();
+    }catch(std::exception const &){
+        // Messages without the key keep their order in the first worker
+        return 0;
+    }
+}
+
+
+void Pipeline::dispatch(std::shared_ptr<Message const> && msg_ptr){
+    PipelineWorker & worker = * workers_[partition(* msg_ptr)];
+    enqueue(* worker.r_queue, msg_ptr, true);
+    worker.task.schedule();
+}
+
+
+std::optional<MessageWrapper> Pipeline::next_outgoing(){
+    size_t n = workers_.size();
+    for(size_t i = 0; i < n; ++i){
+        size_t ix = (next_out_ + i) % n;
+        PipelineWorker & worker = * workers_[ix];
+        if(auto msg_w = worker.s_queue->try_pop()){
+            // Start with the next worker next time, so a busy one can not starve others
+            next_out_ = (ix + 1) % n;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(worker.stalled.load(std::memory_order_relaxed) && worker.stalled.exchange(false)){
+                worker.task.schedule();
+            }
+            return msg_w;
         }
     }
-    if(msg_w.is_passed()) s_queue_.push(msg_w);
+    return std::nullopt;
 }
 
 
-void Pipeline::handle_events(){
-    while(is_active()){
-        try{
-            e_queue_.pop();
-            process();
-        }catch(std::underflow_error){
+// Returns false only if the item does not fit, the policy is "block" and `wait`
+// is false. The item is left intact then.
+template<typename T>
+bool Pipeline::enqueue(SPSCQueue<T> & queue, T & item, bool wait){
+    size_t nbytes = queue.byte_capacity() > 0 ? payload_size(item) : 0;
+    switch(queue_config_.overflow){
+        case OverflowPolicy::Type::BLOCK:
+            if(! wait) return queue.try_push(std::move(item), nbytes);
+            queue.push(std::move(item), nbytes);
             break;
-        }
+        case OverflowPolicy::Type::DROP_NEWEST:
+            if(! queue.try_push(std::move(item), nbytes)) ++count_dropped_;
+            break;
+        case OverflowPolicy::Type::DROP_OLDEST:
+            while(! queue.try_push(std::move(item), nbytes)){
+                // Nothing to evict means the consumer has just made room
+                if(queue.evict()) ++count_dropped_;
+            }
+            break;
+        case OverflowPolicy::Type::DLQ:
+            if(! queue.try_push(std::move(item), nbytes)) dead_letter(item);
+            break;
+    }
+    return true;
+}
+
+
+template<typename T>
+bool Pipeline::offer(SPSCQueue<T> & queue, T & item){
+    size_t nbytes = queue.byte_capacity() > 0 ? payload_size(item) : 0;
+    return queue.try_push(std::move(item), nbytes);
+}
+
+
+size_t Pipeline::payload_size(std::shared_ptr<Message const> const & msg_ptr){
+    return msg_ptr ? msg_ptr->get_raw().size() : 0;
+}
+
+
+size_t Pipeline::payload_size(MessageWrapper & msg_w){
+    return msg_w.view().get_raw().size();
+}
+
+
+// Returns false if a subscriber of the dead letter queue is full, the message is
+// dropped then. The pipeline keeps running either way.
+bool Pipeline::dead_letter(std::shared_ptr<Message const> const & msg_ptr){
+    if(! msg_ptr) return false;
+    try{
+        dlq_->push(msg_ptr);
+    }catch(std::overflow_error const &){
+        ++count_dropped_;
+        return false;
+    }
+    ++count_dead_lettered_;
+    return true;
+}
+
+
+bool Pipeline::dead_letter(MessageWrapper & msg_w){
+    return dead_letter(msg_w.msg_ptr());
+}
+
+
+void Pipeline::handle_events(PipelineWorker & worker){
+    for(unsigned n = worker.pending_events.exchange(0); n > 0 && is_active(); --n){
+        process(worker);
     }
 }
 
 
-void Pipeline::handle_messages(){
-    while(is_active()){
+// The batch goes through the leading filtras which take batches at once, for as
+// long as all its messages take the same route and the filtra does not fail.
+// Then each message goes on alone, in the order they were received.
+void Pipeline::process(PipelineWorker & worker, std::vector<MessageWrapper> & batch){
+    constexpr int DROPPED = -1;
+    auto const & filtras = worker.filtras;
+    std::vector<int> next(batch.size(), 0);
+    int filtra_ix = 0;
+    while(filtra_ix < filtras.size() && filtras[filtra_ix]->takes_batches() && is_active()){
+        FiltraRoute const & route = routes_[filtra_ix];
         try{
-            auto msg_ptr = r_queue_.pop();
-            process(std::move(msg_ptr));
-        }catch(std::underflow_error){
+            filtras[filtra_ix]->process(std::span<MessageWrapper>(batch));
+        }catch(std::exception const &){
+            // One bad message must not cost the others: each goes through this
+            // filtra alone, next[] points at it, and only the failing one is lost
             break;
         }
+
+        bool same_route = true;
+        for(size_t i = 0; i < batch.size(); ++i){
+            MessageWrapper & msg_w = batch[i];
+            if(msg_w.is_passed()){
+                next[i] = route.passed;
+                redirect(route, msg_w);
+            }else if(route.rejected != FiltraRoute::DROP){
+                next[i] = route.rejected;
+                msg_w.pass(); // let message to flow forward
+            }else{
+                next[i] = DROPPED;
+            }
+            same_route = same_route && next[i] == next[0];
+        }
+        if(! same_route || next[0] == DROPPED) break;
+        filtra_ix = next[0];
+    }
+    for(size_t i = 0; i < batch.size(); ++i){
+        if(next[i] != DROPPED) process(worker, batch[i], next[i]);
+    }
+}
+
+
+// Returns false if the worker has to wait for room in its s_queue
+bool Pipeline::handle_messages(PipelineWorker & worker){
+    if(! worker.filtras.empty() && worker.filtras.front()->takes_batches()){
+        return handle_batch(worker);
+    }
+    for(unsigned n = 0; n < TASK_BATCH && is_active(); ++n){
+        auto msg_ptr = worker.r_queue->try_pop();
+        if(! msg_ptr) return true;
+        process(worker, * msg_ptr);
+        if(! flush_backlog(worker)) return false;
+    }
+    // The batch is over, let other tasks run before the rest
+    worker.task.schedule();
+    return true;
+}
+
+
+bool Pipeline::handle_batch(PipelineWorker & worker){
+    auto & batch = worker.batch;
+    while(batch.size() < TASK_BATCH){
+        auto msg_ptr = worker.r_queue->try_pop();
+        if(! msg_ptr) break;
+        batch.emplace_back(std::move(* msg_ptr));
     }
+    if(batch.empty()) return true;
+    bool is_full = batch.size() == TASK_BATCH;
+    if(is_active()) process(worker, batch);
+    batch.clear();
+    if(! flush_backlog(worker)) return false;
+    // Let other tasks run before the rest
+    if(is_full) worker.task.schedule();
+    return true;
 }
 
 
@@ -271,11 +492,20 @@ void Pipeline::run_receiving(ThreadState * thread_state){
         std::cout << state_to_string(state_) << std::endl;
         while(is_active()){
             try{
-                auto msg_ptr = connector_in_->receive();
-                r_queue_.push(std::move(msg_ptr));
-                pipeline_event_.notify_one();
+                if(batch_config_.size > 1){
+                    for(auto & msg_ptr : connector_in_->receive_batch(batch_config_.size, batch_config_.linger)){
+                        dispatch(std::move(msg_ptr));
+                    }
+                }else{
+                    dispatch(connector_in_->receive());
+                }
             }catch(std::underflow_error){
                 break;
+            }catch(std::overflow_error const & e){
+                // r_queue is full and non-blocking only while stopping
+                if(! is_active()) break;
+                last_error_ = e.what();
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }catch(std::exception const & e){
                 last_error_ = e.what();
                 // sleep to prevent while(1) flood (temp.)
@@ -295,102 +525,121 @@ void Pipeline::run_receiving(ThreadState * thread_state){
 }
 
 
-void Pipeline::run_processing(ThreadState * thread_state){
-    * thread_state = ThreadState::STARTING;
+void Pipeline::run_processing(PipelineWorker & worker){
+    if(! is_active()) return;
     try{
-        for(auto filtra : filtras_) filtra->start();
+        // The sending task reschedules a stalled worker when there is room
+        if(! flush_backlog(worker)) return;
+        handle_events(worker);
+        if(! flush_backlog(worker)) return;
+        handle_messages(worker);
     }catch(std::exception const & e){
         last_error_ = e.what();
         state_ = PipelineState::FAILED;
     }
-    * thread_state = ThreadState::RUNNING;
-    try{
-        while(is_active()){
-            handle_events();
-            handle_messages();
-            std::unique_lock<std::mutex> lock(pipeline_event_mtx_);
-            pipeline_event_.wait(lock);
-        }
-    }catch(std::exception const & e){
-        last_error_ = e.what();
-        state_ = PipelineState::FAILED;
-    }
-    std::cout << "run_processing finished" << std::endl;
-    * thread_state = ThreadState::FINISHED;
 }
 
 
-void Pipeline::run_sending(ThreadState * thread_state){
-    * thread_state = ThreadState::STARTING;
-    // Connect
-    try{
-        connector_out_->connect();
-    }catch(std::exception const & e){
-        last_error_ = e.what();
-        state_ = PipelineState::FAILED;
-    }
-    // Sending forever
-    if(state_ != PipelineState::FAILED){
-        * thread_state = ThreadState::RUNNING;
-        while(is_active()){
-            try{
-                auto msg_w = s_queue_.pop();
-                connector_out_->send(msg_w);
-            }catch(std::underflow_error){
-                break;
-            }catch(std::exception const & e){
-                last_error_ = e.what();
-                // sleep to prevent while(1) flood (temp.)
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
+void Pipeline::run_sending(){
+    for(unsigned n = 0; n < TASK_BATCH; ++n){
+        if(! is_active()) return;
+        while(out_batch_.size() < batch_config_.size){
+            auto msg_w = next_outgoing();
+            if(! msg_w) break;
+            if(out_batch_.empty()) out_batch_started_ = std::chrono::steady_clock::now();
+            out_batch_.push_back(std::move(* msg_w));
+        }
+        if(out_batch_.empty()) return;
+
+        // Wait for the batch to fill up, but not longer than linger
+        if(out_batch_.size() < batch_config_.size && batch_config_.linger.count() > 0){
+            auto waited = std::chrono::steady_clock::now() - out_batch_started_;
+            if(waited < batch_config_.linger){
+                if(! linger_armed_.exchange(true)){
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        batch_config_.linger - waited) + std::chrono::milliseconds(1);
+                    schedule_after(left, [this]{
+                        linger_armed_ = false;
+                        sending_task_.schedule();
+                    });
+                }
+                return;
             }
-            last_error_ = "";  // Clear error on successful sending
         }
+
+        try{
+            if(out_batch_.size() == 1){
+                connector_out_->send(out_batch_.front());
+            }else{
+                connector_out_->send_batch(out_batch_);
+            }
+        }catch(std::exception const & e){
+            drop_out_batch(e.what());
+            last_error_ = e.what();
+            // Executor threads are shared, back off with a timer instead of sleeping
+            schedule_after(std::chrono::milliseconds(100), [this]{ sending_task_.schedule(); });
+            return;
+        }
+        out_batch_.clear();
+        last_error_ = "";  // Clear error on successful sending
     }
-    // Disconnect
-    try{
-        connector_out_->disconnect();
-    }catch(std::exception const & e){
-        last_error_ = e.what();
-        state_ = PipelineState::FAILED;
+    // The batch is over, let other tasks run before the rest
+    sending_task_.schedule();
+}
+
+
+// The connector does not tell which messages of a failed batch went out, so all
+// of them are dead-lettered under the "dlq" policy and dropped under the others
+void Pipeline::drop_out_batch(std::string const & error){
+    size_t count = out_batch_.size();
+    if(queue_config_.overflow == OverflowPolicy::Type::DLQ){
+        size_t lettered = 0;
+        for(auto & msg_w : out_batch_){
+            if(dead_letter(msg_w)) ++lettered;
+        }
+        std::cerr << pipeid_ << ": sending failed, " << lettered << " message(s) dead-lettered, "
+                  << count - lettered << " dropped: " << error << std::endl;
+    }else{
+        count_dropped_ += count;
+        std::cerr << pipeid_ << ": sending failed, " << count
+                  << " message(s) dropped: " << error << std::endl;
     }
-    std::cout << "run_sending finished" << std::endl;
-    * thread_state = ThreadState::FINISHED;
+    out_batch_.clear();
 }
 
 
 void Pipeline::run_control(){
     while(is_alive()){
-        std::optional<PipelineCommand> command;
+        PipelineCommand command;
         try{
-            while((command = c_queue_.pop())){
-                switch(* command){
-                    case PipelineCommand::START:
-                        execute_start();
-                        break;
-                    case PipelineCommand::STOP:
-                        execute_stop();
-                        break;
-                    case PipelineCommand::RESTART:
-                        execute_stop();
-                        execute_start();
-                        break;
-                    case PipelineCommand::TERMINATE:
-                        execute_stop();
-                        state_ = PipelineState::TERMINATED;
-                        break;
-                    default:
-                        break;
-                }
-            }
+            command = c_queue_.pop();
         }catch(std::underflow_error){
-            execute_stop();
-            state_ = PipelineState::TERMINATED;
+            return;  // execute() schedules the task again for the next command
+        }
+        try{
+            switch(command){
+                case PipelineCommand::START:
+                    execute_start();
+                    break;
+                case PipelineCommand::STOP:
+                    execute_stop();
+                    break;
+                case PipelineCommand::RESTART:
+                    execute_stop();
+                    execute_start();
+                    break;
+                case PipelineCommand::TERMINATE:
+                    execute_stop();
+                    state_ = PipelineState::TERMINATED;
+                    break;
+                default:
+                    break;
+            }
         }catch(std::exception const & e){
             last_error_ = e.what();
         }
     }
-    std::cout<<pipeid_<<": control thread terminated"<<std::endl;
+    std::cout<<pipeid_<<": terminated"<<std::endl;
     free_resources();
 }
 
@@ -403,11 +652,31 @@ void Pipeline::execute_start(){
     last_error_ = "";
     state_ = PipelineState::RUNNING;
 
-    s_queue_.set_blocking();
+    for(auto & worker : workers_){
+        worker->r_queue->set_blocking();
+        worker->s_queue->set_blocking();
+        worker->stalled = false;
+    }
+    linger_armed_ = false;
+    timers_.open();
+
+    try{
+        connector_out_->connect();
+        for(auto & worker : workers_){
+            for(auto filtra : worker->filtras) filtra->start();
+        }
+    }catch(std::exception const & e){
+        last_error_ = e.what();
+        state_ = PipelineState::FAILED;
+        return;
+    }
 
-    sending_thread_.start(& Pipeline::run_sending, this);
-    processing_thread_.start(& Pipeline::run_processing, this);
-    receiving_thread_.start(& Pipeline::run_receiving, this);
+    // Messages left in the queues by the previous run
+    sending_task_.schedule();
+    for(auto & worker : workers_){
+        worker->task.schedule();
+    }
+    receiving_job_.start(& Pipeline::run_receiving, this);
 }
 
 
@@ -422,22 +691,36 @@ void Pipeline::execute_stop(){
 
     // It helps to exit from blocking receiving call
     if(connector_in_ != nullptr) connector_in_->stop();
-    s_queue_.set_non_blocking();
-    receiving_thread_.terminate();
-    while(processing_thread_.is_running()){
-        pipeline_event_.notify_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for(auto & worker : workers_){
+        worker->r_queue->set_non_blocking();
+        worker->s_queue->set_non_blocking();
+    }
+    receiving_job_.terminate();
+    // Pending timers are cancelled, filtra events scheduled before the stop are dropped
+    timers_.close();
+    // Tasks see that the pipeline is not active and return
+    for(auto & worker : workers_){
+        worker->task.wait_idle();
+    }
+    sending_task_.wait_idle();
+
+    try{
+        if(connector_out_ != nullptr) connector_out_->disconnect();
+    }catch(std::exception const & e){
+        last_error_ = e.what();
     }
-    processing_thread_.terminate();
-    sending_thread_.terminate();
 
     state_ = PipelineState::STOPPED;
 }
 
 
 void Pipeline::execute(PipelineCommand cmd){
-    if(! is_alive() && ! prepare()) return;
+    if(! is_alive()){
+        control_task_.wait_idle();  // let it finish freeing resources
+        if(! prepare()) return;
+    }
     c_queue_.push(cmd);
+    control_task_.schedule();
 }
 
 
@@ -479,10 +762,24 @@ std::string Pipeline::get_last_error() const{
 }
 
 
+void Pipeline::schedule_after(std::chrono::milliseconds msec, std::function<void()> func){
+    timers_.schedule(msec, std::move(func));
+}
+
+
 void Pipeline::schedule_event(std::chrono::milliseconds msec){
-    std::thread([this, msec](){
-        std::this_thread::sleep_for(std::chrono::milliseconds(msec));
-        this->e_queue_.push(true);
-        this->pipeline_event_.notify_one();
-    }).detach();
+    if(! workers_.empty()) schedule_event(* workers_.front(), msec);
+}
+
+
+void Pipeline::schedule_event(PipelineWorker & worker, std::chrono::milliseconds msec){
+    schedule_after(msec, [& worker](){
+        ++worker.pending_events;
+        worker.task.schedule();
+    });
+}
+
+
+void PipelineWorker::schedule_event(std::chrono::milliseconds msec){
+    pipeline->schedule_event(* this, msec);
 }
@@ -27,17 +27,28 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_PIPELINE_H__
 
 
+#include <algorithm>
 #include <thread>
 #include <atomic>
+#include <deque>
+#include <functional>
+#include <optional>
 #include <mutex>
 #include <condition_variable>
 
 #include "m2e_aliases.h"
+#include "m2e_exceptions.h"
 #include "pipeline_iface.h"
 #include "tsqueue.h"
+#include "internal_queue.h"
+#include "utils/spsc_queue.h"
+#include "utils/executor.h"
+#include "utils/blocking_pool.h"
+#include "utils/timer_wheel.h"
 #include "m2e_message/message_wrapper.h"
 #include "filtras/filtra.h"
 #include "connectors/connector.h"
+#include "substitutions/subs.hpp"
 
 
 enum class PipelineState{
@@ -60,11 +71,242 @@ enum class PipelineCommand{
 };
 
 
+struct OverflowPolicy
+{
+    enum class Type{ BLOCK, DROP_OLDEST, DROP_NEWEST, DLQ };
+
+    static std::string to_string(OverflowPolicy::Type v)
+    {
+        switch(v){
+            case Type::BLOCK: return "block";
+            case Type::DROP_OLDEST: return "drop_oldest";
+            case Type::DROP_NEWEST: return "drop_newest";
+            case Type::DLQ: return "dlq";
+            default: throw std::invalid_argument("Invalid OverflowPolicy");
+        }
+    }
+
+    static OverflowPolicy::Type from_string(std::string const & str)
+    {
+        if(str == "block"){ return OverflowPolicy::Type::BLOCK; }
+        if(str == "drop_oldest"){ return OverflowPolicy::Type::DROP_OLDEST; }
+        if(str == "drop_newest"){ return OverflowPolicy::Type::DROP_NEWEST; }
+        if(str == "dlq"){ return OverflowPolicy::Type::DLQ; }
+
+        throw std::invalid_argument("Unknown overflow policy: " + str);
+    }
+};
+
+
+/*
+Limits of the queues between the receiving, processing and sending threads,
+configured by the "queue" object of a pipeline:
+
+"queue": {
+    "capacity": 1024,           // messages per queue
+    "capacity_bytes": 0,        // payload bytes per queue, 0 - unlimited
+    "overflow": "block",        // block | drop_oldest | drop_newest | dlq
+    "dlq": "<queue name>"       // internal queue, required for "dlq"
+}
+
+Messages of a batch the output connector failed to send also go to the "dlq"
+queue under the "dlq" policy, and are dropped under the others. A message which
+does not fit into a subscriber of the "dlq" queue is dropped.
+*/
+struct QueueConfig
+{
+    size_t capacity {1024};
+    size_t capacity_bytes {0};
+    OverflowPolicy::Type overflow {OverflowPolicy::Type::BLOCK};
+    std::string dlq;
+
+    static QueueConfig from_json(json const & config)
+    {
+        QueueConfig qc;
+        if(! config.is_object()){
+            throw configuration_error("Queue config must be an object");
+        }
+        try{
+            qc.capacity = config.value("capacity", qc.capacity);
+            qc.capacity_bytes = config.value("capacity_bytes", qc.capacity_bytes);
+            qc.overflow = OverflowPolicy::from_string(config.value("overflow", "block"));
+            qc.dlq = config.value("dlq", "");
+        }catch(json::exception const & e){
+            throw configuration_error(string("Queue config: ") + e.what());
+        }catch(std::invalid_argument const & e){
+            throw configuration_error(e.what());
+        }
+        if(qc.capacity == 0){
+            throw configuration_error("Queue capacity must be greater than 0");
+        }
+        if(qc.overflow == OverflowPolicy::Type::DLQ && qc.dlq.empty()){
+            throw configuration_error("Queue name is required for \"dlq\" overflow policy");
+        }
+        return qc;
+    }
+};
+
+
+/*
+Batching of the connectors, configured by the "batch" object of a pipeline:
+
+"batch": {
+    "size": 1,      // maximum messages per batch
+    "linger": 0     // milliseconds to wait for a batch to fill up
+}
+*/
+struct BatchConfig
+{
+    size_t size {1};
+    std::chrono::milliseconds linger {0};
+
+    static BatchConfig from_json(json const & config)
+    {
+        BatchConfig bc;
+        if(! config.is_object()){
+            throw configuration_error("Batch config must be an object");
+        }
+        try{
+            bc.size = config.value("size", bc.size);
+            bc.linger = std::chrono::milliseconds(config.value("linger", 0u));
+        }catch(json::exception const & e){
+            throw configuration_error(string("Batch config: ") + e.what());
+        }
+        if(bc.size == 0){
+            throw configuration_error("Batch size must be greater than 0");
+        }
+        return bc;
+    }
+};
+
+
+/*
+Filtra chain with every "goto" resolved to an index, compiled once from the
+"filtras" array of a pipeline, so processing a message does no name lookups.
+
+An index equal to the number of filtras means the connector-out. A chain in
+which a message can loop forever, e.g. a filtra with "goto" pointing to itself,
+is a configuration error.
+*/
+struct FiltraRoute
+{
+    static constexpr int DROP = -1;
+
+    string name;
+    int passed {0};            // next filtra of a passed message
+    int rejected {DROP};       // next filtra of a rejected message, it flows on passed
+    std::vector<string> queue_ids;
+    std::vector<InternalQueue *> queues;  // resolved queue_ids, see RoutingGraph::bind_queues
+};
+
+
+struct RoutingGraph
+{
+    std::vector<FiltraRoute> routes;
+
+    FiltraRoute const & operator[](size_t ix) const { return routes[ix]; }
+    size_t size() const { return routes.size(); }
+
+    static RoutingGraph from_json(json const & filtras)
+    {
+        RoutingGraph graph;
+        if(! filtras.is_array()){
+            throw configuration_error("Filtras must be an array");
+        }
+        std::vector<string> names;
+        for(auto const & filtra : filtras){
+            names.push_back(filtra.value("name", ""));
+        }
+        int out = names.size();
+        auto resolve = [& names, out](string const & hop) -> int {
+            if(hop == "out") return out;
+            auto it = std::find(names.begin(), names.end(), hop);
+            if(it == names.end()){
+                throw configuration_error("Unknown goto filtra: \"" + hop + "\"");
+            }
+            return it - names.begin();
+        };
+
+        for(int ix = 0; ix < out; ++ix){
+            json const & filtra = filtras[ix];
+            FiltraRoute route;
+            route.name = names[ix];
+            try{
+                string goto_hop = filtra.value("goto", "");
+                string passed = filtra.value("goto_passed", filtra.value("goto_accepted", goto_hop));
+                string rejected = filtra.value("goto_rejected", goto_hop);
+                route.passed = passed.empty() ? ix + 1 : resolve(passed);
+                route.rejected = rejected.empty() ? FiltraRoute::DROP : resolve(rejected);
+                if(filtra.contains("queues")){
+                    route.queue_ids = filtra.at("queues").get<std::vector<string>>();
+                }
+            }catch(json::exception const & e){
+                throw configuration_error(string("Filtra config: ") + e.what());
+            }
+            graph.routes.push_back(std::move(route));
+        }
+        graph.check_exits();
+        return graph;
+    }
+
+    void bind_queues()
+    {
+        for(auto & route : routes){
+            route.queues.clear();
+            for(auto const & queuid : route.queue_ids){
+                route.queues.push_back(InternalQueue::get_queue_ptr(queuid));
+            }
+        }
+    }
+
+private:
+    // Every filtra a message can reach must have a way to the connector-out or to a drop
+    void check_exits() const
+    {
+        int out = routes.size();
+        auto is_exit = [out](int ix){ return ix == out || ix == FiltraRoute::DROP; };
+        std::vector<bool> exits(out, false);
+        for(bool changed = true; changed; ){
+            changed = false;
+            for(int ix = 0; ix < out; ++ix){
+                if(exits[ix]) continue;
+                auto const & route = routes[ix];
+                if(is_exit(route.passed) || is_exit(route.rejected)
+                        || exits[route.passed] || exits[route.rejected]){
+                    exits[ix] = changed = true;
+                }
+            }
+        }
+        std::vector<bool> reached(out, false);
+        std::vector<int> stack {0};
+        while(! stack.empty()){
+            int ix = stack.back();
+            stack.pop_back();
+            if(is_exit(ix) || reached[ix]) continue;
+            if(! exits[ix]){
+                string name = routes[ix].name.empty() ? std::to_string(ix) : routes[ix].name;
+                throw configuration_error(
+                    "Filtra \"" + name + "\" loops without a way to the connector-out");
+            }
+            reached[ix] = true;
+            stack.push_back(routes[ix].passed);
+            stack.push_back(routes[ix].rejected);
+        }
+    }
+};
+
+
 struct PipelineStat{
     time_t last_in;
     time_t last_out;
     unsigned long count_in;
     unsigned long count_out;
+    unsigned long count_dropped;       // discarded by drop_oldest / drop_newest or a full dlq, or not sent
+    unsigned long count_dead_lettered; // redirected to the dead letter queue
+    size_t queue_in;                   // messages waiting for processing
+    size_t queue_out;                  // messages waiting for sending
+    size_t queue_bytes;                // payload bytes held by both queues
+    OverflowPolicy::Type overflow;
 };
 
 
@@ -79,13 +321,26 @@ enum class ThreadState {
 };
 
 
-class Thread{
-    std::thread * thread_ {nullptr};
+// Long-running blocking function (e.g. a receiving loop) on the BlockingPool
+class BlockingJob{
     ThreadState state_ {ThreadState::UNKN};
+    bool started_ {false};
+    bool finished_ {false};
+    std::mutex mtx_;
+    std::condition_variable cv_;
 public:
-    void start(void (Pipeline::*func)(ThreadState *), Pipeline * pipeline){
-        if(thread_ != nullptr) throw std::runtime_error("Thread already started!");
-        thread_ = new std::thread(func, pipeline, & state_);
+    template<typename... Params, typename... Args>
+    void start(void (Pipeline::*func)(ThreadState *, Params...), Pipeline * pipeline, Args... args){
+        if(started_) throw std::runtime_error("Job already started!");
+        started_ = true;
+        finished_ = false;
+        state_ = ThreadState::UNKN;
+        BlockingPool::get_instance().submit([this, func, pipeline, args...](){
+            (pipeline->*func)(& state_, args...);
+            std::lock_guard<std::mutex> lock(mtx_);
+            finished_ = true;
+            cv_.notify_all();
+        });
         unsigned cnt {};
         while(state_ == ThreadState::STARTING || state_ == ThreadState::UNKN){
             std::this_thread::sleep_for(chrono::milliseconds(10));
@@ -94,9 +349,10 @@ public:
     }
 
     void terminate(){
-        if(thread_ != nullptr){
-            thread_->join();
-            delete std::exchange(thread_, nullptr);
+        if(started_){
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this]{ return finished_; });
+            started_ = false;
         }
     }
 
@@ -104,9 +360,44 @@ public:
 };
 
 
+/*
+A filtra chain with its own queues. A pipeline configured with "workers": N runs
+N of them, the receiving job distributes messages between workers by the partition
+key, so messages with the same key keep their order.
+
+The chain runs as a SerialTask on the Executor whenever its r_queue gets messages
+or a scheduled event fires. Executor threads are shared by all pipelines and must
+not block, so with the "block" overflow policy messages which do not fit into
+the s_queue wait in the backlog, and the worker stops taking new ones until the
+sending task makes room and reschedules it.
+*/
+struct PipelineWorker: public PipelineIface{
+    Pipeline * pipeline;
+    std::vector<Filtra *> filtras;
+    std::unique_ptr<SPSCQueue<std::shared_ptr<Message const>>> r_queue;
+    std::unique_ptr<SPSCQueue<MessageWrapper>> s_queue;
+    std::deque<MessageWrapper> backlog;
+    std::vector<MessageWrapper> batch;  // reused by handle_batch
+    std::atomic<bool> stalled {false};  // waits for room in s_queue
+    // Scheduled filtra events not yet handled. A counter instead of a queue,
+    // pending events carry no data and can not pile up memory.
+    std::atomic<unsigned> pending_events {0};
+    SerialTask task;
+
+    explicit PipelineWorker(Pipeline * pipeline);
+
+    void schedule_event(std::chrono::milliseconds msec) override;
+};
+
+
 class Pipeline:public PipelineIface{
+    friend struct PipelineWorker;
     bool is_enabled_ {};
 public:
+    static constexpr unsigned MAX_WORKERS = 64;
+    // Messages handled by one run of a processing or sending task
+    static constexpr unsigned TASK_BATCH = 64;
+
     Pipeline(std::string const & pipeid, json const & pjson);
     ~Pipeline();
 
@@ -116,6 +407,7 @@ public:
     Pipeline & operator=(Pipeline &&) = delete;
 
     void schedule_event(std::chrono::milliseconds msec);
+    void schedule_event(PipelineWorker & worker, std::chrono::milliseconds msec);
 
     void execute(PipelineCommand cmd);
     void start();
@@ -133,6 +425,9 @@ public:
     std::string get_id() const;
     std::string get_last_error() const;
 
+    // Index of the worker which gets the message, by the hash of its partition key
+    size_t partition(Message const & msg);
+
     PipelineStat get_statistics()const{
         PipelineStat stat = {};
         if(connector_in_){
@@ -143,6 +438,14 @@ public:
             stat.last_out = connector_out_->get_statistics().last_out;
             stat.count_out = connector_out_->get_statistics().count_out;
         }
+        stat.count_dropped = count_dropped_;
+        stat.count_dead_lettered = count_dead_lettered_;
+        for(auto const & worker : workers_){
+            stat.queue_in += worker->r_queue->size();
+            stat.queue_out += worker->s_queue->size();
+            stat.queue_bytes += worker->r_queue->bytes() + worker->s_queue->bytes();
+        }
+        stat.overflow = queue_config_.overflow;
         return stat;
     }
 
@@ -172,37 +475,66 @@ private:
     bool prepare();
     void execute_stop();
     void execute_start();
-    void process(std::shared_ptr<Message> const & msg_ptr, int filtra_ix = 0);
-    void process();
-    void handle_events();
-    void handle_messages();
+    void process(PipelineWorker & worker, std::shared_ptr<Message const> const & msg_ptr, int filtra_ix = 0);
+    void process(PipelineWorker & worker, MessageWrapper & msg_w, int filtra_ix);
+    void process(PipelineWorker & worker, std::vector<MessageWrapper> & batch);
+    void process(PipelineWorker & worker);
+    void forward(PipelineWorker & worker, MessageWrapper && msg_w);
+    bool flush_backlog(PipelineWorker & worker);
+    void dispatch(std::shared_ptr<Message const> && msg_ptr);
+    std::optional<MessageWrapper> next_outgoing();
+    template<typename T>
+    bool enqueue(SPSCQueue<T> & queue, T & item, bool wait);
+    template<typename T>
+    bool offer(SPSCQueue<T> & queue, T & item);
+    void schedule_after(std::chrono::milliseconds msec, std::function<void()> func);
+    size_t payload_size(std::shared_ptr<Message const> const & msg_ptr);
+    size_t payload_size(MessageWrapper & msg_w);
+    bool dead_letter(std::shared_ptr<Message const> const & msg_ptr);
+    bool dead_letter(MessageWrapper & msg_w);
+    void drop_out_batch(std::string const & error);
+    void handle_events(PipelineWorker & worker);
+    bool handle_messages(PipelineWorker & worker);
+    bool handle_batch(PipelineWorker & worker);
     void run_receiving(ThreadState * running);
-    void run_processing(ThreadState * running);
-    void run_sending(ThreadState * running);
+    void run_processing(PipelineWorker & worker);
+    void run_sending();
     void run_control();
     void free_resources();
-    int find_filtra_index(string const & filtra_name);
+    void redirect(FiltraRoute const & route, MessageWrapper & msg_w);
 
     Connector * connector_in_ {nullptr};
     Connector * connector_out_ {nullptr};
-    std::vector<Filtra *> filtras_;
+    std::vector<std::unique_ptr<PipelineWorker>> workers_;
+    RoutingGraph routes_;  // same for the chains of all workers
+    CompiledTemplate partition_key_;
+    size_t next_out_ {0};  // worker the sending task polls first
     std::string pipeid_;
     json config_;
 
-    Thread processing_thread_;
-    Thread receiving_thread_;
-    Thread sending_thread_;
-    std::thread * control_thread_ {nullptr};
+    // Receiving blocks in the connector, so it has a BlockingPool thread while the
+    // pipeline is running. Processing and sending are Executor tasks, control
+    // commands may wait for connectors and run on the BlockingPool.
+    BlockingJob receiving_job_;
+    SerialTask sending_task_ {Executor::get_instance(), [this]{ run_sending(); }};
+    SerialTask control_task_ {BlockingPool::get_instance(), [this]{ run_control(); }};
+    // Open while the pipeline runs, stopping cancels whatever is pending
+    TimerGroup timers_;
     PipelineState state_ {PipelineState::STOPPED};
     std::string last_error_;
 
-    std::mutex pipeline_event_mtx_;
-    std::condition_variable pipeline_event_;
-
-    TSQueue<std::shared_ptr<Message>> r_queue_ {0, false};
-    TSQueue<bool> e_queue_ {0, false};
-    TSQueue<MessageWrapper> s_queue_;
-    TSQueue<PipelineCommand> c_queue_;
+    // Worker queues have exactly one producer and one consumer:
+    // receiving -> processing -> sending. All are sized by queue_config_.
+    QueueConfig queue_config_;
+    InternalQueue * dlq_ {nullptr};  // resolved queue_config_.dlq, see construct()
+    BatchConfig batch_config_;
+    // Owned by the sending task
+    std::vector<MessageWrapper> out_batch_;
+    std::chrono::steady_clock::time_point out_batch_started_;
+    std::atomic<bool> linger_armed_ {false};
+    std::atomic<unsigned long> count_dropped_ {0};
+    std::atomic<unsigned long> count_dead_lettered_ {0};
+    TSQueue<PipelineCommand> c_queue_ {0, false};
 
 };
 
@@ -251,6 +251,12 @@ private:
         j_status["last_out"] = stat.last_out;
         j_status["count_in"] = stat.count_in;
         j_status["count_out"] = stat.count_out;
+        j_status["count_dropped"] = stat.count_dropped;
+        j_status["count_dead_lettered"] = stat.count_dead_lettered;
+        j_status["queue_in"] = stat.queue_in;
+        j_status["queue_out"] = stat.queue_out;
+        j_status["queue_bytes"] = stat.queue_bytes;
+        j_status["overflow"] = OverflowPolicy::to_string(stat.overflow);
         return j_status;
     }
 
@@ -23,8 +23,9 @@ IN THE SOFTWARE.
 */
 
 
+#include <optional>
+
 #include <tao/pegtl.hpp>
-#include <cbor.h>
 
 #include "modifiers/modifier.h"
 
@@ -33,19 +34,61 @@ IN THE SOFTWARE.
 
 class ObjectProxy
 {
+    // TOPIC_LEVELS of a message, indexed without splitting the whole topic
+    struct TopicLevels{
+        Message const * msg;
+    };
+
+    // Raw text of a JSON value, members are located in it without decoding the payload
+    struct JsonText{
+        std::string_view text;
+    };
+
     std::variant<
-        Message *,
+        Message const *,
         nlohmann::json const *,
-        std::vector<std::string> const *,
+        JsonText,
+        TopicLevels,
+        std::string_view,
         std::string const *,
         std::map<std::string, std::string> const *,
-        cbor_item_t const *,
+        CborValue,
         MessageExtra const *
     > obj_;
+    // Keeps a JSON value decoded from JsonText alive for the proxies pointing into it
+    std::shared_ptr<nlohmann::json const> owner_;
+
+    static ObjectProxy decode(std::string_view text){
+        auto doc = std::make_shared<nlohmann::json const>(nlohmann::json::parse(text));
+        ObjectProxy proxy(doc.get());
+        proxy.owner_ = std::move(doc);
+        return proxy;
+    }
+
+    ObjectProxy(JsonText text){
+        obj_ = text;
+    }
+
+    ObjectProxy derived(ObjectProxy && proxy) const{
+        proxy.owner_ = owner_;
+        return std::move(proxy);
+    }
+
+    static substituted_t json_value(nlohmann::json const & j){
+        if(j.is_string()){
+            return j.get<std::string>();
+        }
+        else if(j.is_number_integer()){
+            return std::to_string(j.template get<unsigned>());
+        }
+        else{
+            return j;
+        }
+    }
 public:
     ObjectProxy() = default;
 
-    ObjectProxy(Message * msg){
+    ObjectProxy(Message const * msg){
         obj_ = msg;
     }
 
@@ -53,12 +96,16 @@ public:
         obj_ = j;
     }
 
-    ObjectProxy(cbor_item_t const * c){
+    ObjectProxy(CborValue const & c){
         obj_ = c;
     }
 
-    ObjectProxy(std::vector<std::string> const * v){
-        obj_ = v;
+    ObjectProxy(TopicLevels levels){
+        obj_ = levels;
+    }
+
+    ObjectProxy(std::string_view s){
+        obj_ = s;
     }
 
     ObjectProxy(std::string const * s){
@@ -74,38 +121,47 @@ public:
     }
 
     ObjectProxy next(std::string const & key){
-        if(std::holds_alternative<Message *>(obj_)){
+        if(std::holds_alternative<Message const *>(obj_)){
             if(key == "PAYLOAD"){
-                Message * msg = std::get<Message *>(obj_);
+                Message const * msg = std::get<Message const *>(obj_);
                 switch(msg->get_format()){
                     case MessageFormat::Type::JSON:
-                        return ObjectProxy(&std::get<Message *>(obj_)->get_json());
+                        if(auto text = msg->get_json_text()){
+                            return ObjectProxy(JsonText{* text});
+                        }
+                        return ObjectProxy(& msg->get_json());
                     case MessageFormat::Type::CBOR:
-                        return ObjectProxy(std::get<Message *>(obj_)->get_cbor());
+                        return ObjectProxy(std::get<Message const *>(obj_)->get_cbor());
                 }
             }
             else if(key == "TOPIC_LEVELS"){
-                return ObjectProxy(& std::get<Message *>(obj_)->get_topic_levels());
+                return ObjectProxy(TopicLevels{std::get<Message const *>(obj_)});
             }
             else if(key == "TOPIC"){
-                return ObjectProxy(& std::get<Message *>(obj_)->get_topic());
+                return ObjectProxy(& std::get<Message const *>(obj_)->get_topic());
             }
         }
         else if(std::holds_alternative<nlohmann::json const *>(obj_)){
-            return ObjectProxy(&std::get<nlohmann::json const *>(obj_)->at(key));
+            return derived(ObjectProxy(&std::get<nlohmann::json const *>(obj_)->at(key)));
+        }
+        else if(std::holds_alternative<JsonText>(obj_)){
+            std::string_view text = std::get<JsonText>(obj_).text;
+            auto res = JsonScanner::find_member(text, key);
+            if(res.status == JsonScanner::Status::FOUND){
+                return ObjectProxy(JsonText{res.value});
+            }
+            else if(res.status == JsonScanner::Status::INVALID){
+                return decode(text).next(key);
+            }
         }
         else if(std::holds_alternative<std::map<std::string, std::string> const *>(obj_)){
             return ObjectProxy(&std::get<std::map<std::string, std::string> const *>(obj_)->at(key));
         }
-        else if(std::holds_alternative<cbor_item_t const *>(obj_)){
-            cbor_item_t const * cbor_map = std::get<cbor_item_t const *>(obj_);
-            struct cbor_pair *pairs = cbor_map_handle(cbor_map);
-            size_t map_size = cbor_map_size(cbor_map);
-            for (size_t i = 0; i < map_size; ++i){
-                char *map_key = (char *)cbor_string_handle(pairs[i].key);
-                size_t map_key_len = cbor_string_length(pairs[i].key);
-                if(key.compare(0, key.size(), map_key, map_key_len) == 0){
-                    return ObjectProxy(pairs[i].value);
+        else if(std::holds_alternative<CborValue>(obj_)){
+            CborValue const & cbor_map = std::get<CborValue>(obj_);
+            if(cbor_map.is_map()){
+                if(auto value = cbor_map.find(key)){
+                    return ObjectProxy(* value);
                 }
             }
         }
@@ -119,10 +175,30 @@ public:
     }
 
     ObjectProxy next(unsigned ix){
-        if(std::holds_alternative<std::vector<std::string> const *>(obj_)){
-            return ObjectProxy(& std::get<std::vector<std::string> const *>(obj_)->at(ix));
+        if(std::holds_alternative<TopicLevels>(obj_)){
+            auto level = std::get<TopicLevels>(obj_).msg->find_topic_level(ix);
+            if(! level) throw std::out_of_range(fmt::format("Topic has no level {}!", ix));
+            return ObjectProxy(* level);
         }else if(std::holds_alternative<nlohmann::json const *>(obj_)){
-            return ObjectProxy(& std::get<nlohmann::json const *>(obj_)->at(ix));
+            return derived(ObjectProxy(& std::get<nlohmann::json const *>(obj_)->at(ix)));
+        }else if(std::holds_alternative<JsonText>(obj_)){
+            std::string_view text = std::get<JsonText>(obj_).text;
+            auto res = JsonScanner::find_element(text, ix);
+            if(res.status == JsonScanner::Status::FOUND){
+                return ObjectProxy(JsonText{res.value});
+            }
+            else if(res.status == JsonScanner::Status::INVALID){
+                return decode(text).next(ix);
+            }
+            throw std::out_of_range(fmt::format("Can not find index: {}!", ix));
+        }else if(std::holds_alternative<CborValue>(obj_)){
+            CborValue const & cbor_array = std::get<CborValue>(obj_);
+            if(cbor_array.is_array()){
+                if(auto value = cbor_array.at(ix)){
+                    return ObjectProxy(* value);
+                }
+                throw std::out_of_range(fmt::format("Can not find index: {}!", ix));
+            }
         }
         throw std::invalid_argument("Index access is not available!");
     }
@@ -131,57 +207,34 @@ public:
         if(std::holds_alternative<std::string const *>(obj_)){
             return *std::get<std::string const *>(obj_);
         }
+        else if(std::holds_alternative<std::string_view>(obj_)){
+            return std::string(std::get<std::string_view>(obj_));
+        }
         else if(std::holds_alternative<nlohmann::json const *>(obj_)){
-            nlohmann::json const *j = std::get<nlohmann::json const *>(obj_);
-            if(j->is_string()){
-                return std::get<nlohmann::json const *>(obj_)->get<std::string>();
-            }
-            else if(j->is_number_integer()){
-                return std::to_string(std::get<nlohmann::json const *>(obj_)->template get<unsigned>());
-            }
-            else{
-                return *std::get<nlohmann::json const *>(obj_);
-            }
+            return json_value(* std::get<nlohmann::json const *>(obj_));
         }
-        else if(std::holds_alternative<cbor_item_t const *>(obj_)){
-            cbor_item_t const * item = std::get<cbor_item_t const *>(obj_);
+        else if(std::holds_alternative<JsonText>(obj_)){
+            return json_value(nlohmann::json::parse(std::get<JsonText>(obj_).text));
+        }
+        else if(std::holds_alternative<CborValue>(obj_)){
+            CborValue const & item = std::get<CborValue>(obj_);
 
-            if( cbor_is_int(item) )
-            {
-                cbor_int_width width = cbor_int_get_width(item);
-                switch(width){
-                    case CBOR_INT_8: return static_cast<long>(cbor_get_uint8(item));
-                    case CBOR_INT_16: return static_cast<long>(cbor_get_uint16(item));
-                    case CBOR_INT_32: return static_cast<long>(cbor_get_uint32(item));
-                    case CBOR_INT_64: return static_cast<long>(cbor_get_uint64(item));
-                }
-            }
-            else if( cbor_is_float(item) )
+            switch( item.type() )
             {
-                cbor_float_width width = cbor_float_get_width(item);
-                switch(width){
-                    case CBOR_FLOAT_16: return static_cast<double>(cbor_float_get_float2(item));
-                    case CBOR_FLOAT_32: return static_cast<double>(cbor_float_get_float4(item));
-                    case CBOR_FLOAT_64: return static_cast<double>(cbor_float_get_float8(item));
-                }
-            }
-            else if( cbor_is_bool(item) )
-            {
-                return cbor_get_bool(item);
-            }
-            else if( cbor_isa_bytestring(item) )
-            {
-                return std::span<byte const>(
-                    reinterpret_cast<byte *>(cbor_bytestring_handle(item)),
-                    cbor_bytestring_length(item)
-                );
-            }
-            else if( cbor_isa_string(item) )
-            {
-                return std::string(
-                    reinterpret_cast<char *>(cbor_string_handle(item)),
-                    reinterpret_cast<char *>(cbor_string_handle(item) + cbor_string_length(item))
-                );
+                case CborValue::Type::UINT:
+                case CborValue::Type::NEGINT:
+                    return static_cast<long>(item.as_int());
+                case CborValue::Type::FLOAT:
+                    return item.as_double();
+                case CborValue::Type::FALSE:
+                case CborValue::Type::TRUE:
+                    return item.as_bool();
+                case CborValue::Type::BYTES:
+                    return item.bytes();
+                case CborValue::Type::TEXT:
+                    return std::string(item.text());
+                default:
+                    break;
             }
         }
         else if(std::holds_alternative<MessageExtra const *>(obj_)){
@@ -202,7 +255,8 @@ namespace grammar {
     struct pipe : tao::pegtl::string<'|'> {};
     struct lbracket : tao::pegtl::string<'['> {};
     struct rbracket : tao::pegtl::string<']'> {};
-    struct modifier : seq<pipe, identifier_first, star<identifier_other>, opt<comma, plus<digit>>> {};
+    // |name followed by any number of integer parameters, e.g. |resize,320 or |resize,320,240
+    struct modifier : seq<pipe, identifier_first, star<identifier_other>, star<comma, plus<digit>>> {};
     struct property : seq<dot, identifier_first, star<identifier_other>> {};
     struct index : seq<lbracket, plus<digit>, rbracket> {};
     struct expression : seq<identifier, plus<sor<property, index>>, opt<modifier>> {};
@@ -212,15 +266,19 @@ namespace grammar {
 class EvalState {
     EnvObjects & env_;
     ObjectProxy obj_;
-    std::vector<unsigned char> value_;
+    std::optional<substituted_t> modified_;
 public:
     EvalState( EnvObjects & env ) :env_(env) {}
 
-    void start(std::string const & name){
-        auto v = env_.at(name);
-        if( std::holds_alternative<Message *>(v) )
+    void start(EnvRoot::Type root){
+        EnvObject const & v = env_[static_cast<size_t>(root)];
+        if( std::holds_alternative<std::monostate>(v) )
+        {
+            throw std::out_of_range("Substitution object is not available!");
+        }
+        else if( std::holds_alternative<Message const *>(v) )
         {
-            obj_ = ObjectProxy(std::get<Message *>(v));
+            obj_ = ObjectProxy(std::get<Message const *>(v));
         }
         else if( std::holds_alternative<json const *>(v) )
         {
@@ -237,9 +295,9 @@ public:
     }
 
     substituted_t get_value(){
-        if( value_.size() > 0 )
+        if( modified_ )
         {
-            return value_;
+            return std::move(* modified_);
         }
         else{
             return obj_.value();
@@ -255,15 +313,15 @@ public:
         obj_ = obj_.next(ix);
     }
 
-    void modify( std::string const & modifier_def )
+    void modify( Modifier & modifier, ModifierMemo & memo )
     {
         auto substituted = obj_.value();
         auto value = std::get<std::span<std::byte const>>(substituted);
 
-        Modifier modifier { modifier_def };
-
         try{
-            value_ = modifier.modify(value);
+            modified_ = memo.apply(& modifier, value, [& modifier](std::span<std::byte const> input){
+                return modifier.modify(input);
+            });
         }
         catch(std::exception const & e)
         {
@@ -279,52 +337,100 @@ struct action {};
 template<>
 struct action<grammar::identifier> {
     template<typename Input>
-    static void apply(const Input & in, EvalState & state) {
-        state.start(in.string());
+    static void apply(const Input & in, CompiledTemplate::Expression & expr) {
+        expr.root = EnvRoot::from_string(in.string());
     }
 };
 
 template<>
 struct action<grammar::property> {
     template<typename Input>
-    static void apply(const Input & in, EvalState & state) {
+    static void apply(const Input & in, CompiledTemplate::Expression & expr) {
         auto p = in.string();
-        state.next(std::string(p.begin() + 1, p.end()));
+        expr.path.push_back({std::string(p.begin() + 1, p.end())});
     }
 };
 
 template<>
 struct action<grammar::modifier> {
     template<typename Input>
-    static void apply(const Input & in, EvalState & state) {
+    static void apply(const Input & in, CompiledTemplate::Expression & expr) {
         auto p = in.string();
-        state.modify(std::string(p.begin() + 1, p.end()));
+        expr.modifier = std::string(p.begin() + 1, p.end());
     }
 };
 
 template<>
 struct action<grammar::index> {
     template<typename Input>
-    static void apply(const Input & in, EvalState & state) {
+    static void apply(const Input & in, CompiledTemplate::Expression & expr) {
         auto p = in.string();
-        state.next(std::stoi(std::string(p.begin() + 1, p.end() - 1)));
+        expr.path.push_back({"", static_cast<unsigned>(std::stoul(std::string(p.begin() + 1, p.end() - 1))), true});
     }
 };
 
 
-substituted_t SubsEngine::evaluate( string const & expression )
+CompiledTemplate::CompiledTemplate( string const & atemplate ): source_(atemplate)
 {
-    EvalState state(env_);
+    // Same matches as the \{\{(.*?)\}\} regex used before compiling templates
+    size_t pos = 0;
+    size_t search = 0;
+    while( (search = atemplate.find("{{", search)) != string::npos )
+    {
+        size_t end = atemplate.find("}}", search + 2);
+        if( end == string::npos ) break;
+
+        string source = atemplate.substr(search + 2, end - search - 2);
+        if( source.find('\n') != string::npos )
+        {
+            ++search;
+            continue;
+        }
+
+        Expression expr;
+        expr.source = source;
+        tao::pegtl::string_input in(source, "");
+        if( ! tao::pegtl::parse<grammar::expression, action>(in, expr) )
+        {
+            throw configuration_error(fmt::format("Can not parse expression: {}!", source));
+        }
+        if( ! expr.modifier.empty() )
+        {
+            try{
+                expr.modifier_ptr = Modifier::get(expr.modifier);
+            }catch( std::invalid_argument const & e ){
+                throw configuration_error(fmt::format("{} in expression: {}!", e.what(), source));
+            }
+        }
+
+        literals_.back() = atemplate.substr(pos, search - pos);
+        literals_.emplace_back();
+        expressions_.push_back(std::move(expr));
+        pos = search = end + 2;
+    }
+    literals_.back() = atemplate.substr(pos);
+}
 
-    tao::pegtl::string_input in(expression, "");
 
-    try{
-        tao::pegtl::parse<grammar::expression, action>(in, state);
+substituted_t SubsEngine::evaluate( CompiledTemplate::Expression const & expression )
+{
+    EvalState state(env_);
 
-        return state.get_value();
+    state.start(expression.root);
+    for( auto const & step : expression.path )
+    {
+        if( step.is_index )
+        {
+            state.next(step.index);
+        }
+        else{
+            state.next(step.key);
+        }
     }
-    catch(std::exception const & e)
+    if( expression.modifier_ptr )
     {
-        throw;
+        state.modify(* expression.modifier_ptr, memo_);
     }
+
+    return state.get_value();
 }
@@ -27,20 +27,49 @@ IN THE SOFTWARE.
 #define __M2E_BRIDGE_SUBS_H__
 
 
-#include <regex>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 #include <span>
 
 #include <fmt/core.h>
 
 #include "m2e_aliases.h"
+#include "m2e_exceptions.h"
 #include "shared_objects.h"
 #include "m2e_message/message_wrapper.h"
 
 
 using StringMap = std::map<std::string, std::string>;
-using EnvObjects = std::map<std::string, std::variant<Message *, json const *, StringMap const *, MessageExtra const *>>;
+
+class Modifier;
+
+
+// Root objects of substitution expressions, resolved from their names when a template is compiled
+struct EnvRoot
+{
+    enum class Type{ MSG, META, ATTR, EXTRA, SHARED, COUNT };
+
+    static EnvRoot::Type from_string(std::string_view str)
+    {
+        if( str == "MSG" ){ return EnvRoot::Type::MSG; }
+        if( str == "META" ){ return EnvRoot::Type::META; }
+        if( str == "ATTR" ){ return EnvRoot::Type::ATTR; }
+        if( str == "EXTRA" ){ return EnvRoot::Type::EXTRA; }
+        if( str == "SHARED" ){ return EnvRoot::Type::SHARED; }
+
+        throw configuration_error(fmt::format("Unknown substitution object: {}!", str));
+    }
+};
+
+using EnvObject = std::variant<std::monostate, Message const *, json const *, StringMap const *, MessageExtra const *>;
+// Indexed by EnvRoot::Type, an environment is filled with pointers only
+using EnvObjects = std::array<EnvObject, static_cast<size_t>(EnvRoot::Type::COUNT)>;
 
 using substituted_t = std::variant<
         bool,
@@ -53,62 +82,186 @@ using substituted_t = std::variant<
 >;
 
 
+/*
+A template compiled once, at configuration time: the literal text around the
+{{...}} expressions, and each expression parsed into a root object, an accessor
+path and an optional modifier, e.g. MSG.PAYLOAD.a.b[3]|resize,200.
+Substituting a compiled template does neither regex search nor parsing.
+*/
+class CompiledTemplate{
+public:
+    struct Step{
+        string key;
+        unsigned index {0};
+        bool is_index {false};
+    };
+
+    struct Expression{
+        EnvRoot::Type root {EnvRoot::Type::MSG};
+        std::vector<Step> path;
+        string modifier;
+        // Shared by every template using the same modifier notation
+        std::shared_ptr<Modifier> modifier_ptr;
+        string source;
+    };
+
+    CompiledTemplate() = default;
+
+    // Throws configuration_error if an expression can not be parsed
+    explicit CompiledTemplate(string const & atemplate);
+
+    string const & source() const{
+        return source_;
+    }
+
+    bool is_dynamic() const{
+        return ! expressions_.empty();
+    }
+
+    // The template is one expression, substituting it keeps the type of the value
+    bool is_single_expression() const{
+        return expressions_.size() == 1 && literals_[0].empty() && literals_[1].empty();
+    }
+
+private:
+    friend class SubsEngine;
+
+    string source_;
+    // Text before, between and after the expressions, one more than expressions_
+    std::vector<string> literals_ {""};
+    std::vector<Expression> expressions_;
+};
+
+
+/*
+Modifier results of one message. A template which modifies the same value more
+than once, or several templates substituted with one engine, run the modifier
+once per distinct input. Results are found by the modifier and the input bytes,
+hashed first and then compared, and are kept while they fit in the byte budget.
+*/
+class ModifierMemo{
+public:
+    static constexpr size_t DEFAULT_BUDGET = 16 * 1024 * 1024;
+
+    explicit ModifierMemo(size_t budget = DEFAULT_BUDGET): budget_(budget) {}
+
+    // A kept result comes back as a span, valid as long as the memo. A result
+    // over the budget comes back as its own vector.
+    template<typename Modify>
+    substituted_t apply(void const * modifier, std::span<std::byte const> input, Modify && modify){
+        size_t hash = std::hash<std::string_view>{}(
+            std::string_view(reinterpret_cast<char const *>(input.data()), input.size()));
+        for( auto const & entry : entries_ )
+        {
+            if( entry.modifier == modifier && entry.hash == hash
+                    && std::equal(input.begin(), input.end(), entry.input.begin(), entry.input.end()) )
+            {
+                return as_bytes(entry.result);
+            }
+        }
+
+        std::vector<unsigned char> result = modify(input);
+        size_t cost = input.size() + result.size();
+        if( cost > budget_ - used_ )
+        {
+            return result;
+        }
+        used_ += cost;
+        entries_.push_back({modifier, hash, {input.begin(), input.end()}, std::move(result)});
+        // Moving entries keeps the buffers of their vectors, the spans stay valid
+        return as_bytes(entries_.back().result);
+    }
+
+    void clear(){
+        entries_.clear();
+        used_ = 0;
+    }
+
+    size_t size() const{
+        return entries_.size();
+    }
+
+private:
+    struct Entry{
+        void const * modifier;
+        size_t hash;
+        std::vector<std::byte> input;
+        std::vector<unsigned char> result;
+    };
+
+    static std::span<std::byte const> as_bytes(std::vector<unsigned char> const & v){
+        return {reinterpret_cast<std::byte const *>(v.data()), v.size()};
+    }
+
+    size_t budget_;
+    size_t used_ {0};
+    // Few modifiers run per message, a linear search beats hashing the keys
+    std::vector<Entry> entries_;
+};
+
+
+// Create one engine per message, modifier results are memoized for its lifetime.
+// Binary values of modified expressions may point into the engine, use them before
+// it goes away.
 class SubsEngine {
     EnvObjects env_;
-    substituted_t evaluate(string const & exptrssion);
+    ModifierMemo memo_;
+    substituted_t evaluate(CompiledTemplate::Expression const & expression);
+
+    void set(EnvRoot::Type root, EnvObject obj){
+        env_[static_cast<size_t>(root)] = obj;
+    }
 public:
-    SubsEngine(Message & msg, json const & meta, json const & attr){
-        env_["MSG"] = & msg;
-        env_["META"] = & meta;
-        env_["ATTR"] = & attr;
+    SubsEngine(Message const & msg, json const & meta, json const & attr){
+        set(EnvRoot::Type::MSG, & msg);
+        set(EnvRoot::Type::META, & meta);
+        set(EnvRoot::Type::ATTR, & attr);
         // For now, only JSON shared objects are supported
-        env_["SHARED"] = & SharedObjects::get_json();
+        set(EnvRoot::Type::SHARED, & SharedObjects::get_json());
     }
 
-    SubsEngine(Message & msg, json const & meta, StringMap const & attr){
-        env_["MSG"] = & msg;
-        env_["META"] = & meta;
-        env_["ATTR"] = & attr;
+    SubsEngine(Message const & msg, json const & meta, StringMap const & attr){
+        set(EnvRoot::Type::MSG, & msg);
+        set(EnvRoot::Type::META, & meta);
+        set(EnvRoot::Type::ATTR, & attr);
         // For now, only JSON shared objects are supported
-        env_["SHARED"] = & SharedObjects::get_json();
+        set(EnvRoot::Type::SHARED, & SharedObjects::get_json());
     }
 
     SubsEngine(MessageWrapper & msg_w){
-        env_["MSG"] = & msg_w.msg();
-        env_["META"] = & msg_w.get_metadata();
-        env_["ATTR"] = & msg_w.msg().get_attributes();
-        env_["EXTRA"] = & msg_w.get_extra();
+        set(EnvRoot::Type::MSG, & msg_w.view());
+        set(EnvRoot::Type::META, & msg_w.get_metadata());
+        set(EnvRoot::Type::ATTR, & msg_w.view().get_attributes());
+        set(EnvRoot::Type::EXTRA, & msg_w.get_extra());
         // For now, only JSON shared objects are supported
-        env_["SHARED"] = & SharedObjects::get_json();
+        set(EnvRoot::Type::SHARED, & SharedObjects::get_json());
     }
 
-    substituted_t substitute(string const & atemplate){
+    substituted_t substitute(CompiledTemplate const & atemplate){
         using namespace std;
-        regex pattern("\\{\\{(.*?)\\}\\}");
-        smatch match;
-        string result = atemplate;
         try{
-            auto pos = result.cbegin();
-            while(regex_search(pos, result.cend(), match, pattern)){
-                string expression = match[1].str();
-                if(match[0].str() == atemplate){
-                    return evaluate(expression);
-                }else{
-                    try{
-                        string vvalue {std::get<string>(evaluate(expression))};
-                        unsigned int i = (pos - result.cbegin());
-                        result.replace(i + match.position(), match.length(), vvalue);
-                        // Restore iterator after string modification
-                        pos = result.cbegin() + i + match.position() + vvalue.size();
-                    }catch(json::exception){
-                        throw runtime_error(fmt::format("Can not evaluate: {}!", expression));
-                    }
+            if(atemplate.is_single_expression()){
+                return evaluate(atemplate.expressions_[0]);
+            }
+            string result = atemplate.literals_[0];
+            for(size_t i = 0; i < atemplate.expressions_.size(); ++i){
+                auto const & expression = atemplate.expressions_[i];
+                try{
+                    result += std::get<string>(evaluate(expression));
+                }catch(json::exception){
+                    throw runtime_error(fmt::format("Can not evaluate: {}!", expression.source));
                 }
+                result += atemplate.literals_[i + 1];
             }
+            return result;
         }catch(json::exception const e){
             throw runtime_error(e.what());
         }
-        return result;
+    }
+
+    // Compiles the template on every call, prefer keeping a CompiledTemplate
+    substituted_t substitute(string const & atemplate){
+        return substitute(CompiledTemplate(atemplate));
     }
 };
 
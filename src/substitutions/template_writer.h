@@ -0,0 +1,265 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_TEMPLATE_WRITER_H__
+#define __M2E_BRIDGE_TEMPLATE_WRITER_H__
+
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "m2e_aliases.h"
+#include "m2e_exceptions.h"
+#include "substitutions/subs.hpp"
+#include "utils/base64.h"
+
+
+/*
+A JSON template serialized ahead of time: runs of encoded bytes for its static
+parts, with a slot for each string holding {{...}} expressions. Writing the
+template substitutes the slots and appends everything straight to the output,
+as JSON text or CBOR, without building a json tree. Binary values are written
+as CBOR byte strings, or as base64 strings in JSON.
+*/
+class TemplateWriter
+{
+public:
+    enum class Encoding {JSON, CBOR};
+
+    TemplateWriter() = default;
+
+    // Throws configuration_error if an expression can not be parsed
+    TemplateWriter(json const & tmpl, Encoding encoding): encoding_(encoding)
+    {
+        compile(tmpl);
+        literals_.push_back(std::move(pending_));
+        pending_.clear();
+    }
+
+    Encoding encoding() const
+    {
+        return encoding_;
+    }
+
+    void write(SubsEngine & se, string & out) const
+    {
+        out += literals_[0];
+        for( size_t i = 0; i < slots_.size(); ++i )
+        {
+            auto result = se.substitute(slots_[i]);
+            if( encoding_ == Encoding::JSON ){
+                write_json(result, out);
+            }else{
+                write_cbor(result, out);
+            }
+            out += literals_[i + 1];
+        }
+    }
+
+private:
+    Encoding encoding_ {Encoding::JSON};
+    // Encoded bytes before, between and after the slots, one more than slots_
+    std::vector<string> literals_;
+    std::vector<CompiledTemplate> slots_;
+    string pending_;
+
+    void compile(json const & j)
+    {
+        if( j.is_object() )
+        {
+            if( encoding_ == Encoding::JSON ){
+                pending_ += '{';
+            }else{
+                cbor_head(5, j.size(), pending_);
+            }
+            bool first = true;
+            for( auto const & [key, value] : j.items() )
+            {
+                if( encoding_ == Encoding::JSON ){
+                    if( ! first ) pending_ += ',';
+                    json_string(key, pending_);
+                    pending_ += ':';
+                }else{
+                    cbor_text(key, pending_);
+                }
+                first = false;
+                compile(value);
+            }
+            if( encoding_ == Encoding::JSON ) pending_ += '}';
+        }
+        else if( j.is_array() )
+        {
+            if( encoding_ == Encoding::JSON ){
+                pending_ += '[';
+            }else{
+                cbor_head(4, j.size(), pending_);
+            }
+            bool first = true;
+            for( auto const & item : j )
+            {
+                if( encoding_ == Encoding::JSON && ! first ) pending_ += ',';
+                first = false;
+                compile(item);
+            }
+            if( encoding_ == Encoding::JSON ) pending_ += ']';
+        }
+        else if( j.is_string() )
+        {
+            CompiledTemplate compiled(j.get<string>());
+            if( compiled.is_dynamic() ){
+                literals_.push_back(std::move(pending_));
+                pending_.clear();
+                slots_.push_back(std::move(compiled));
+            }else{
+                write_json_value(j, pending_);
+            }
+        }
+        else
+        {
+            write_json_value(j, pending_);
+        }
+    }
+
+    void write_json_value(json const & j, string & out) const
+    {
+        if( encoding_ == Encoding::JSON ){
+            out += j.dump();
+        }else{
+            json::to_cbor(j, out);
+        }
+    }
+
+    void write_json(substituted_t const & value, string & out) const
+    {
+        std::visit([&out, this](auto const & v){
+            using T = std::decay_t<decltype(v)>;
+            if constexpr( std::is_same_v<T, string> ){
+                json_string(v, out);
+            }else if constexpr( std::is_same_v<T, bool> ){
+                out += v ? "true" : "false";
+            }else if constexpr( std::is_same_v<T, long> ){
+                append_number(v, out);
+            }else if constexpr( std::is_same_v<T, json> ){
+                write_json_value(v, out);
+            }else if constexpr( std::is_same_v<T, double> ){
+                write_json_value(json(v), out);
+            }else{
+                // Binary values become base64 strings, which need no escaping
+                out += '"';
+                base64_append(std::span(v.data(), v.size()), out);
+                out += '"';
+            }
+        }, value);
+    }
+
+    void write_cbor(substituted_t const & value, string & out) const
+    {
+        std::visit([&out, this](auto const & v){
+            using T = std::decay_t<decltype(v)>;
+            if constexpr( std::is_same_v<T, string> ){
+                cbor_text(v, out);
+            }else if constexpr( std::is_same_v<T, bool> ){
+                out += static_cast<char>(v ? 0xF5 : 0xF4);
+            }else if constexpr( std::is_same_v<T, long> ){
+                if( v >= 0 ){
+                    cbor_head(0, static_cast<uint64_t>(v), out);
+                }else{
+                    cbor_head(1, static_cast<uint64_t>(-1 - v), out);
+                }
+            }else if constexpr( std::is_same_v<T, json> ){
+                write_json_value(v, out);
+            }else if constexpr( std::is_same_v<T, double> ){
+                write_json_value(json(v), out);
+            }else{
+                // Binary values keep their type as a byte string
+                cbor_head(2, v.size(), out);
+                out.append(reinterpret_cast<char const *>(v.data()), v.size());
+            }
+        }, value);
+    }
+
+    template<typename T>
+    static void append_number(T value, string & out)
+    {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, res.ptr);
+    }
+
+    static void json_string(std::string_view str, string & out)
+    {
+        static constexpr char HEX[] = "0123456789abcdef";
+        out += '"';
+        size_t run = 0;
+        for( size_t i = 0; i < str.size(); ++i )
+        {
+            unsigned char c = static_cast<unsigned char>(str[i]);
+            if( c >= 0x20 && c != '"' && c != '\\' ) continue;
+            out.append(str.data() + run, i - run);
+            run = i + 1;
+            switch( c ){
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    out += "\\u00";
+                    out += HEX[c >> 4];
+                    out += HEX[c & 0x0F];
+            }
+        }
+        out.append(str.data() + run, str.size() - run);
+        out += '"';
+    }
+
+    static void cbor_text(std::string_view str, string & out)
+    {
+        cbor_head(3, str.size(), out);
+        out += str;
+    }
+
+    static void cbor_head(uint8_t major, uint64_t arg, string & out)
+    {
+        char type = static_cast<char>(major << 5);
+        if( arg < 24 ){
+            out += static_cast<char>(type | arg);
+            return;
+        }
+        int bytes = arg <= 0xFF ? 1 : arg <= 0xFFFF ? 2 : arg <= 0xFFFFFFFF ? 4 : 8;
+        out += static_cast<char>(type | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27));
+        for( int i = bytes - 1; i >= 0; --i ){
+            out += static_cast<char>((arg >> (8 * i)) & 0xFF);
+        }
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_TEMPLATE_WRITER_H__
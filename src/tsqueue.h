@@ -28,6 +28,7 @@ IN THE SOFTWARE.
 
 
 #include <queue>
+#include <chrono>
 #include <mutex>
 #include <optional>
 #include <condition_variable>
@@ -87,6 +88,18 @@ public:
         queue_.pop();
         return el;
     }
+
+    // Waits up to `timeout` for an element, never throws on an empty queue
+    std::optional<T> try_pop(std::chrono::milliseconds timeout = std::chrono::milliseconds(0)){
+        std::unique_lock<std::mutex> lock(mtx_);
+        if(timeout.count() > 0){
+            cv_.wait_for(lock, timeout, [this]{ return ! queue_.empty() || ! blocking_; });
+        }
+        if(queue_.empty()) return std::nullopt;
+        std::optional<T> el {std::move(queue_.front())};
+        queue_.pop();
+        return el;
+    }
 };
 
 
@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_AHO_CORASICK_H__
+#define __M2E_BRIDGE_AHO_CORASICK_H__
+
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/*
+Multi-pattern matcher: all patterns are found in one pass over the text.
+
+The trie with failure links is compiled into a DFA over byte classes, bytes
+which occur in no pattern sharing one class, so a step is a single table
+lookup and the table stays small. Case-insensitive matching folds ASCII
+letters into the same class. Outside of a partial match, bytes which start no
+pattern are skipped without touching the table.
+*/
+class AhoCorasick
+{
+public:
+    static constexpr int NO_MATCH = -1;
+
+    AhoCorasick(std::vector<std::string> const & patterns, bool case_insensitive = false)
+    {
+        if( patterns.empty() )
+        {
+            throw std::invalid_argument("At least one pattern is required");
+        }
+
+        build_classes(patterns, case_insensitive);
+
+        // Trie, with transitions over byte classes
+        std::vector<std::vector<int32_t>> next(1, std::vector<int32_t>(n_classes_, -1));
+        out_.assign(1, NO_MATCH);
+        for( size_t ix = 0; ix < patterns.size(); ++ix )
+        {
+            if( patterns[ix].empty() )
+            {
+                throw std::invalid_argument("Patterns must not be empty");
+            }
+            int32_t state = 0;
+            for( unsigned char c : patterns[ix] )
+            {
+                int32_t & to = next[state][classes_[c]];
+                if( to < 0 )
+                {
+                    to = static_cast<int32_t>(next.size());
+                    next.emplace_back(n_classes_, -1);
+                    out_.push_back(NO_MATCH);
+                }
+                state = next[state][classes_[c]];
+            }
+            if( out_[state] == NO_MATCH ) out_[state] = static_cast<int>(ix);
+        }
+
+        // Breadth first: resolve missing transitions through failure links
+        delta_.assign(next.size() * n_classes_, 0);
+        std::vector<int32_t> fail(next.size(), 0);
+        std::deque<int32_t> queue;
+        for( size_t cls = 0; cls < n_classes_; ++cls )
+        {
+            int32_t to = next[0][cls];
+            if( to > 0 )
+            {
+                delta_[cls] = to;
+                queue.push_back(to);
+            }
+        }
+        while( ! queue.empty() )
+        {
+            int32_t state = queue.front();
+            queue.pop_front();
+            // A pattern ending at the failure state ends here as well
+            if( out_[state] == NO_MATCH ) out_[state] = out_[fail[state]];
+            for( size_t cls = 0; cls < n_classes_; ++cls )
+            {
+                int32_t to = next[state][cls];
+                if( to > 0 )
+                {
+                    fail[to] = delta_[fail[state] * n_classes_ + cls];
+                    delta_[state * n_classes_ + cls] = to;
+                    queue.push_back(to);
+                }
+                else{
+                    delta_[state * n_classes_ + cls] = delta_[fail[state] * n_classes_ + cls];
+                }
+            }
+        }
+    }
+
+    // Index of the pattern whose match ends first in text, NO_MATCH if none does
+    int find_first( std::string_view text ) const
+    {
+        int32_t state = 0;
+        size_t pos = 0;
+        size_t const n = text.size();
+        while( pos < n )
+        {
+            if( state == 0 )
+            {
+                while( pos < n && ! starts_[static_cast<unsigned char>(text[pos])] ) ++pos;
+                if( pos == n ) break;
+            }
+            state = delta_[state * n_classes_ + classes_[static_cast<unsigned char>(text[pos++])]];
+            if( out_[state] != NO_MATCH ) return out_[state];
+        }
+        return NO_MATCH;
+    }
+
+    size_t states() const
+    {
+        return out_.size();
+    }
+
+private:
+    std::array<uint16_t, 256> classes_ {};
+    std::array<bool, 256> starts_ {};
+    size_t n_classes_ {1};
+    std::vector<int32_t> delta_;
+    // Pattern matched on entering a state
+    std::vector<int> out_;
+
+    void build_classes( std::vector<std::string> const & patterns, bool case_insensitive )
+    {
+        // Class 0 holds the bytes which occur in no pattern
+        for( auto const & pattern : patterns )
+        {
+            for( size_t i = 0; i < pattern.size(); ++i )
+            {
+                unsigned char c = pattern[i];
+                unsigned char folded = case_insensitive ? fold(c) : c;
+                if( classes_[folded] == 0 )
+                {
+                    classes_[folded] = static_cast<uint16_t>(n_classes_++);
+                }
+                if( i == 0 ) starts_[folded] = true;
+            }
+        }
+        if( case_insensitive )
+        {
+            for( unsigned c = 'A'; c <= 'Z'; ++c )
+            {
+                classes_[c] = classes_[c - 'A' + 'a'];
+                starts_[c] = starts_[c - 'A' + 'a'];
+            }
+        }
+    }
+
+    static unsigned char fold( unsigned char c )
+    {
+        return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_AHO_CORASICK_H__
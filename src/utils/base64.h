@@ -0,0 +1,136 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_BASE64_H__
+#define __M2E_BRIDGE_BASE64_H__
+
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+
+/*
+Standard base64 (RFC 4648) with padding. The output is sized once and written
+through a pointer; with SSSE3 enabled at build time, 12 input bytes are encoded
+per step with byte shuffles, the rest byte triplet by triplet.
+*/
+
+namespace base64_detail
+{
+    inline constexpr char ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+#if defined(__SSSE3__)
+    // Encodes the first 12 bytes of the 16 at src into 16 characters
+    inline void encode_block(unsigned char const * src, char * dst)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src));
+        // Each 32 bit lane gets 3 input bytes, as b1 b0 b2 b1
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        // Move the four 6 bit indices of each lane into separate bytes
+        __m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)),
+                                     _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)),
+                                     _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(hi, lo);
+        // Offset from each index to its character, by range of the index
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        __m128i const offsets = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        __m128i out = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), out);
+    }
+#endif
+}
+
+
+inline void base64_append(std::span<unsigned char const> data, std::string & out)
+{
+    using base64_detail::ALPHABET;
+
+    size_t start = out.size();
+    out.resize(start + (data.size() + 2) / 3 * 4);
+    char * dst = out.data() + start;
+    unsigned char const * src = data.data();
+    unsigned char const * end = src + data.size();
+
+#if defined(__SSSE3__)
+    // A block reads 16 bytes and consumes 12
+    while( end - src >= 16 ){
+        base64_detail::encode_block(src, dst);
+        src += 12;
+        dst += 16;
+    }
+#endif
+
+    while( end - src >= 3 ){
+        unsigned triplet = (src[0] << 16) | (src[1] << 8) | src[2];
+        dst[0] = ALPHABET[triplet >> 18];
+        dst[1] = ALPHABET[(triplet >> 12) & 0x3F];
+        dst[2] = ALPHABET[(triplet >> 6) & 0x3F];
+        dst[3] = ALPHABET[triplet & 0x3F];
+        src += 3;
+        dst += 4;
+    }
+
+    if( end - src == 1 ){
+        dst[0] = ALPHABET[src[0] >> 2];
+        dst[1] = ALPHABET[(src[0] & 0x03) << 4];
+        dst[2] = '=';
+        dst[3] = '=';
+    }else if( end - src == 2 ){
+        dst[0] = ALPHABET[src[0] >> 2];
+        dst[1] = ALPHABET[((src[0] & 0x03) << 4) | (src[1] >> 4)];
+        dst[2] = ALPHABET[(src[1] & 0x0F) << 2];
+        dst[3] = '=';
+    }
+}
+
+
+inline void base64_append(std::span<std::byte const> data, std::string & out)
+{
+    base64_append({reinterpret_cast<unsigned char const *>(data.data()), data.size()}, out);
+}
+
+
+inline std::string base64_encode(std::string_view input)
+{
+    std::string encoded;
+    base64_append({reinterpret_cast<unsigned char const *>(input.data()), input.size()}, encoded);
+    return encoded;
+}
+
+
+#endif  // __M2E_BRIDGE_BASE64_H__
@@ -0,0 +1,127 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_BLOCKING_POOL_H__
+#define __M2E_BRIDGE_BLOCKING_POOL_H__
+
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "executor.h"
+
+
+/*
+Elastic pool of threads for tasks that block: connector receive loops, connecting
+and disconnecting, pipeline control commands. Keeping them here lets the Executor
+workers run only short tasks.
+
+A task is handed to an idle thread if there is one, otherwise a new thread is
+started. Threads idle for longer than IDLE_TIMEOUT exit.
+*/
+
+class BlockingPool: public TaskRunner
+{
+    static constexpr auto IDLE_TIMEOUT = std::chrono::seconds(60);
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable exit_cv_;
+    std::deque<ExecutorTask *> tasks_;
+    size_t threads_ {0};
+    size_t idle_ {0};
+    bool stopping_ {false};
+
+public:
+    using TaskRunner::submit;
+
+    BlockingPool() = default;
+    BlockingPool(BlockingPool const &) = delete;
+    BlockingPool & operator=(BlockingPool const &) = delete;
+
+    ~BlockingPool()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        stopping_ = true;
+        cv_.notify_all();
+        // Busy threads may be stuck in a blocking call, do not wait for them forever
+        exit_cv_.wait_for(lock, std::chrono::seconds(1), [this]{ return threads_ == 0; });
+    }
+
+    static BlockingPool & get_instance()
+    {
+        static BlockingPool instance;
+        return instance;
+    }
+
+    void submit(ExecutorTask * task) override
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        tasks_.push_back(task);
+        if( idle_ >= tasks_.size() ){
+            cv_.notify_one();
+        }else{
+            ++threads_;
+            std::thread(& BlockingPool::run_thread, this).detach();
+        }
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return threads_;
+    }
+
+private:
+    void run_thread()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while( true ){
+            if( ! tasks_.empty() ){
+                ExecutorTask * task = tasks_.front();
+                tasks_.pop_front();
+                lock.unlock();
+                run_task(task);
+                lock.lock();
+                continue;
+            }
+            if( stopping_ ) break;
+            ++idle_;
+            bool woken = cv_.wait_for(lock, IDLE_TIMEOUT, [this]{
+                return ! tasks_.empty() || stopping_;
+            });
+            --idle_;
+            if( ! woken ) break;
+        }
+        --threads_;
+        exit_cv_.notify_all();
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_BLOCKING_POOL_H__
@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_EVENT_COUNT_H__
+#define __M2E_BRIDGE_EVENT_COUNT_H__
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+
+
+/*
+Lets a thread sleep until some lock-free condition becomes true without making
+the notifying side pay for a mutex or a futex wakeup when nobody is sleeping.
+
+Waiter:
+    auto key = ec.prepare_wait();
+    if( condition() ){ ec.cancel_wait(); }
+    else{ ec.wait(key); }
+
+Notifier:
+    make condition true;
+    ec.notify_all();
+*/
+
+class EventCount
+{
+    // High 32 bits - epoch, low 32 bits - number of waiters
+    std::atomic<uint64_t> state_ {0};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+
+    static constexpr uint64_t WAITER = 1;
+    static constexpr uint64_t EPOCH = uint64_t(1) << 32;
+    static constexpr uint64_t WAITERS_MASK = EPOCH - 1;
+
+public:
+    EventCount() = default;
+    EventCount(EventCount const &) = delete;
+    EventCount & operator=(EventCount const &) = delete;
+
+    uint32_t prepare_wait()
+    {
+        uint64_t prev = state_.fetch_add(WAITER, std::memory_order_seq_cst);
+        // Order the waiter registration before the caller re-checks its condition
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return static_cast<uint32_t>(prev >> 32);
+    }
+
+    void cancel_wait()
+    {
+        state_.fetch_sub(WAITER, std::memory_order_seq_cst);
+    }
+
+    void wait(uint32_t key)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this, key]{
+            return static_cast<uint32_t>(state_.load(std::memory_order_acquire) >> 32) != key;
+        });
+        state_.fetch_sub(WAITER, std::memory_order_seq_cst);
+    }
+
+    template<class Rep, class Period>
+    void wait_for(uint32_t key, std::chrono::duration<Rep, Period> const & timeout)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait_for(lock, timeout, [this, key]{
+            return static_cast<uint32_t>(state_.load(std::memory_order_acquire) >> 32) != key;
+        });
+        state_.fetch_sub(WAITER, std::memory_order_seq_cst);
+    }
+
+    void notify_one()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if( (state_.load(std::memory_order_relaxed) & WAITERS_MASK) == 0 ) return;
+        state_.fetch_add(EPOCH, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(mtx_);
+        cv_.notify_one();
+    }
+
+    void notify_all()
+    {
+        // Order the caller's publication before the waiters check
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if( (state_.load(std::memory_order_relaxed) & WAITERS_MASK) == 0 ) return;
+        state_.fetch_add(EPOCH, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(mtx_);
+        cv_.notify_all();
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_EVENT_COUNT_H__
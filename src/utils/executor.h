@@ -0,0 +1,334 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_EXECUTOR_H__
+#define __M2E_BRIDGE_EXECUTOR_H__
+
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "event_count.h"
+#include "work_stealing_deque.h"
+
+
+class ExecutorTask
+{
+public:
+    virtual ~ExecutorTask() = default;
+    // Called once per submit. A one-shot task deletes itself at the end of run().
+    virtual void run() = 0;
+};
+
+
+class FunctionTask: public ExecutorTask
+{
+    std::function<void()> func_;
+public:
+    explicit FunctionTask(std::function<void()> func): func_(std::move(func)) {}
+
+    void run() override
+    {
+        std::unique_ptr<FunctionTask> self(this);
+        func_();
+    }
+};
+
+
+class TaskRunner
+{
+public:
+    virtual ~TaskRunner() = default;
+    virtual void submit(ExecutorTask * task) = 0;
+
+    // Submits a task which gives way to the tasks already waiting, e.g. a task resubmitting itself
+    virtual void yield(ExecutorTask * task)
+    {
+        submit(task);
+    }
+
+    void submit(std::function<void()> func)
+    {
+        submit(new FunctionTask(std::move(func)));
+    }
+
+protected:
+    static void run_task(ExecutorTask * task)
+    {
+        try{
+            task->run();
+        }catch(std::exception const & e){
+            std::cerr << "Unhandled exception in task: " << e.what() << std::endl;
+        }
+    }
+};
+
+
+/*
+Process-wide pool of a fixed number of threads running short, non-blocking tasks.
+
+Every worker has a work-stealing deque. Tasks submitted from a worker go to its own
+deque, tasks submitted from other threads go to a shared injection queue. An idle
+worker takes from its own deque first, then from the injection queue, then steals
+from the other workers, and finally sleeps on an EventCount.
+
+Yielded tasks go to the back of the injection queue, and every INJECT_INTERVAL tasks
+a worker looks at the injection queue first, so tasks which keep resubmitting
+themselves do not starve the others.
+
+Tasks must not block: a task waiting for another task may wait forever once all
+workers are busy. Blocking calls belong to BlockingPool.
+*/
+
+class Executor: public TaskRunner
+{
+    static constexpr unsigned SPIN_COUNT = 64;
+    static constexpr unsigned INJECT_INTERVAL = 61;
+
+    struct Worker
+    {
+        WorkStealingDeque<ExecutorTask *> deque;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex inject_mtx_;
+    std::deque<ExecutorTask *> injected_;
+    std::atomic<size_t> injected_size_ {0};
+    EventCount idle_;
+    std::atomic<bool> stopping_ {false};
+
+    static inline thread_local Executor * current_ {nullptr};
+    static inline thread_local size_t current_ix_ {0};
+    static inline std::atomic<unsigned> configured_threads_ {0};
+
+public:
+    using TaskRunner::submit;
+
+    explicit Executor(unsigned threads = default_threads())
+    {
+        if( threads == 0 ) threads = default_threads();
+        for( unsigned ix = 0; ix < threads; ++ix ){
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for( unsigned ix = 0; ix < threads; ++ix ){
+            workers_[ix]->thread = std::thread(& Executor::run_worker, this, ix);
+        }
+    }
+
+    Executor(Executor const &) = delete;
+    Executor & operator=(Executor const &) = delete;
+
+    ~Executor()
+    {
+        stopping_ = true;
+        idle_.notify_all();
+        for( auto & worker : workers_ ){
+            worker->thread.join();
+        }
+    }
+
+    // Number of threads of the process-wide instance, must be called before its first use
+    static void configure(unsigned threads)
+    {
+        configured_threads_ = threads;
+    }
+
+    static Executor & get_instance()
+    {
+        static Executor instance(configured_threads_);
+        return instance;
+    }
+
+    static unsigned default_threads()
+    {
+        return std::max(2u, std::thread::hardware_concurrency());
+    }
+
+    unsigned size() const
+    {
+        return workers_.size();
+    }
+
+    void submit(ExecutorTask * task) override
+    {
+        if( current_ == this ){
+            workers_[current_ix_]->deque.push(task);
+        }else{
+            inject(task);
+        }
+        idle_.notify_one();
+    }
+
+    void yield(ExecutorTask * task) override
+    {
+        inject(task);
+        idle_.notify_one();
+    }
+
+private:
+    void inject(ExecutorTask * task)
+    {
+        std::lock_guard<std::mutex> lock(inject_mtx_);
+        injected_.push_back(task);
+        injected_size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ExecutorTask * take_injected()
+    {
+        if( injected_size_.load(std::memory_order_relaxed) == 0 ) return nullptr;
+        std::lock_guard<std::mutex> lock(inject_mtx_);
+        if( injected_.empty() ) return nullptr;
+        ExecutorTask * task = injected_.front();
+        injected_.pop_front();
+        injected_size_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    ExecutorTask * find_task(size_t ix, std::minstd_rand & rng, unsigned tick)
+    {
+        if( tick % INJECT_INTERVAL == 0 ){
+            if( ExecutorTask * task = take_injected() ) return task;
+        }
+        if( ExecutorTask * task = workers_[ix]->deque.pop() ) return task;
+        if( ExecutorTask * task = take_injected() ) return task;
+
+        size_t n = workers_.size();
+        size_t start = rng() % n;
+        for( size_t i = 0; i < n; ++i ){
+            size_t victim = (start + i) % n;
+            if( victim == ix ) continue;
+            if( ExecutorTask * task = workers_[victim]->deque.steal() ) return task;
+        }
+        return nullptr;
+    }
+
+    bool has_work() const
+    {
+        if( injected_size_.load(std::memory_order_relaxed) > 0 ) return true;
+        for( auto const & worker : workers_ ){
+            if( ! worker->deque.empty() ) return true;
+        }
+        return false;
+    }
+
+    void run_worker(size_t ix)
+    {
+        current_ = this;
+        current_ix_ = ix;
+        std::minstd_rand rng(ix + 1);
+        unsigned spin = 0;
+        unsigned tick = 0;
+        while( true ){
+            if( ExecutorTask * task = find_task(ix, rng, ++tick) ){
+                run_task(task);
+                spin = 0;
+                continue;
+            }
+            if( stopping_ ) break;
+            if( ++spin < SPIN_COUNT ){
+                std::this_thread::yield();
+                continue;
+            }
+            auto key = idle_.prepare_wait();
+            if( has_work() || stopping_.load(std::memory_order_seq_cst) ){
+                idle_.cancel_wait();
+            }else{
+                idle_.wait(key);
+            }
+            spin = 0;
+        }
+        current_ = nullptr;
+    }
+};
+
+
+/*
+Runs a function on a TaskRunner, never concurrently with itself.
+
+schedule() called while the function runs makes it run once more afterwards, so
+a producer can schedule after every push without losing a wake-up and without
+piling up tasks. The function should handle a bounded amount of work and call
+schedule() again if something is left, so other tasks get their turn.
+*/
+
+class SerialTask: public ExecutorTask
+{
+    TaskRunner & runner_;
+    std::function<void()> func_;
+    std::atomic<unsigned> pending_ {0};
+
+public:
+    SerialTask(TaskRunner & runner, std::function<void()> func)
+        :runner_(runner), func_(std::move(func)) {}
+
+    SerialTask(SerialTask const &) = delete;
+    SerialTask & operator=(SerialTask const &) = delete;
+
+    void schedule()
+    {
+        if( pending_.fetch_add(1, std::memory_order_acq_rel) == 0 ){
+            runner_.submit(this);
+        }
+    }
+
+    void run() override
+    {
+        unsigned n = pending_.load(std::memory_order_acquire);
+        try{
+            func_();
+        }catch(std::exception const & e){
+            std::cerr << "Unhandled exception in serial task: " << e.what() << std::endl;
+        }
+        // Must be the last access to `this`, the owner may destroy an idle task
+        if( pending_.fetch_sub(n, std::memory_order_acq_rel) != n ){
+            runner_.yield(this);
+        }
+    }
+
+    bool is_idle() const
+    {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+    // Must not be called from the task itself
+    void wait_idle() const
+    {
+        while( ! is_idle() ){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_EXECUTOR_H__
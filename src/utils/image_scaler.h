@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_IMAGE_SCALER_H__
+#define __M2E_BRIDGE_IMAGE_SCALER_H__
+
+
+#include <span>
+#include <stdexcept>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "m2e_aliases.h"
+#include "utils/image_size.h"
+
+
+/*
+Resizes encoded images to a target size and encodes them as JPEG, WebP or PNG.
+
+A JPEG at least twice as large as the target is decoded at 1/2, 1/4 or 1/8 of
+its resolution by the decoder itself, which skips most of the decoding work,
+and only the rest of the way is interpolated. The decoded, resized and encoded
+images of resize() live in per-thread buffers reused from call to call.
+
+Several scalers can share one decoding, see decode() and encode().
+*/
+class ImageScaler
+{
+public:
+    enum class Format {JPEG, WEBP, PNG};
+
+    static constexpr int DEFAULT_QUALITY = 90;
+
+    static Format format_from_string(string const & str)
+    {
+        if( str == "jpeg" || str == "jpg" ) return Format::JPEG;
+        if( str == "webp" ) return Format::WEBP;
+        if( str == "png" ) return Format::PNG;
+        throw std::invalid_argument("Unknown image format: " + str);
+    }
+
+    // A width or height of 0 follows the aspect ratio of the image, both 0 keep its size.
+    // PNG is lossless, its quality is ignored.
+    ImageScaler(int width, int height, int quality = DEFAULT_QUALITY, Format format = Format::JPEG):
+        width_(width), height_(height)
+    {
+        if( width < 0 || height < 0 ){
+            throw std::invalid_argument("Image size must not be negative!");
+        }
+        if( quality < 0 || quality > 100 ){
+            throw std::invalid_argument("Image quality must be from 0 to 100!");
+        }
+        switch( format ){
+            case Format::JPEG:
+                ext_ = ".jpeg";
+                params_ = {cv::IMWRITE_JPEG_QUALITY, quality};
+                break;
+            case Format::WEBP:
+                ext_ = ".webp";
+                params_ = {cv::IMWRITE_WEBP_QUALITY, std::max(1, quality)};
+                break;
+            case Format::PNG:
+                ext_ = ".png";
+                break;
+        }
+    }
+
+    // The encoded image, valid until the next call from the same thread
+    uchars const & resize(std::span<unsigned char const> image) const
+    {
+        thread_local cv::Mat decoded;
+        thread_local cv::Mat resized;
+        thread_local uchars encoded;
+
+        decode(image, std::span<ImageScaler const>(this, 1), decoded);
+        encode(decoded, resized, encoded);
+        return encoded;
+    }
+
+    // Decodes the image at the lowest resolution still large enough for every scaler
+    static void decode(std::span<unsigned char const> image, std::span<ImageScaler const> scalers,
+                       cv::Mat & decoded)
+    {
+        int factor = 8;
+        auto source = ImageSize::probe(image);
+        if( ! source || source->format != ImageSize::Format::JPEG ){
+            factor = 1;
+        }else{
+            for( auto const & scaler : scalers ){
+                factor = std::min(factor, scaler.reduction(* source));
+            }
+        }
+        int flags = factor == 8 ? cv::IMREAD_REDUCED_COLOR_8 :
+                    factor == 4 ? cv::IMREAD_REDUCED_COLOR_4 :
+                    factor == 2 ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_COLOR;
+
+        // The matrix header wraps the image without copying it
+        cv::Mat input(1, static_cast<int>(image.size()), CV_8UC1,
+                      const_cast<unsigned char *>(image.data()));
+        cv::imdecode(input, flags, & decoded);
+        if( decoded.empty() ){
+            throw std::runtime_error("Can not decode image!");
+        }
+    }
+
+    // Resizes the decoded image into scratch, unless it has the target size, and encodes it
+    void encode(cv::Mat const & decoded, cv::Mat & scratch, uchars & encoded) const
+    {
+        cv::Size size = target_size(decoded.cols, decoded.rows);
+        if( size == decoded.size() ){
+            cv::imencode(ext_, decoded, encoded, params_);
+        }else{
+            cv::resize(decoded, scratch, size, 0, 0, cv::INTER_LINEAR);
+            cv::imencode(ext_, scratch, encoded, params_);
+        }
+    }
+
+private:
+    int width_;
+    int height_;
+    string ext_;
+    vector<int> params_;
+
+    cv::Size target_size(int cols, int rows) const
+    {
+        if( width_ > 0 && height_ > 0 ) return {width_, height_};
+        if( width_ > 0 ) return {width_, std::max(1, static_cast<int>(rows * (double(width_) / cols)))};
+        if( height_ > 0 ) return {std::max(1, static_cast<int>(cols * (double(height_) / rows))), height_};
+        return {cols, rows};
+    }
+
+    // The largest of 8, 4, 2 and 1 by which the JPEG can be reduced while decoding
+    int reduction(ImageSize const & source) const
+    {
+        if( width_ == 0 && height_ == 0 ) return 1;
+        // EXIF may rotate the stored image, the factor must fit both orientations
+        int shorter = std::min(source.width, source.height);
+        int longest_target = std::max(width_, height_);
+        for( int factor : {8, 4, 2} ){
+            if( shorter / factor >= longest_target ) return factor;
+        }
+        return 1;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_IMAGE_SCALER_H__
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_IMAGE_SIZE_H__
+#define __M2E_BRIDGE_IMAGE_SIZE_H__
+
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+
+/*
+Image dimensions read from the headers of an encoded image, without decoding it.
+JPEG and PNG are recognized; the JPEG size is the stored one, before any EXIF
+rotation.
+*/
+struct ImageSize
+{
+    enum class Format {JPEG, PNG};
+
+    Format format;
+    int width;
+    int height;
+
+    static std::optional<ImageSize> probe(std::span<unsigned char const> data)
+    {
+        if( data.size() >= 24 && data[0] == 0x89 && data[1] == 'P' && data[2] == 'N' && data[3] == 'G' ){
+            // The IHDR chunk comes first, after the 8 byte signature
+            return ImageSize{Format::PNG, static_cast<int>(be32(data, 16)), static_cast<int>(be32(data, 20))};
+        }
+        if( data.size() >= 4 && data[0] == 0xFF && data[1] == 0xD8 ){
+            return probe_jpeg(data);
+        }
+        return std::nullopt;
+    }
+
+private:
+    static uint32_t be16(std::span<unsigned char const> data, size_t pos)
+    {
+        return (data[pos] << 8) | data[pos + 1];
+    }
+
+    static uint32_t be32(std::span<unsigned char const> data, size_t pos)
+    {
+        return (be16(data, pos) << 16) | be16(data, pos + 2);
+    }
+
+    static std::optional<ImageSize> probe_jpeg(std::span<unsigned char const> data)
+    {
+        size_t pos = 2;
+        while( pos + 4 <= data.size() ){
+            if( data[pos] != 0xFF ) return std::nullopt;
+            unsigned char marker = data[pos + 1];
+            if( marker == 0xFF ){  // fill byte
+                ++pos;
+                continue;
+            }
+            if( marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7) ){  // no length
+                pos += 2;
+                continue;
+            }
+            if( marker == 0xD9 || marker == 0xDA ) return std::nullopt;  // no frame before the scan
+            size_t length = be16(data, pos + 2);
+            bool is_frame = marker >= 0xC0 && marker <= 0xCF
+                && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+            if( is_frame ){
+                // Length, precision, height, width
+                if( pos + 9 > data.size() ) return std::nullopt;
+                return ImageSize{Format::JPEG,
+                    static_cast<int>(be16(data, pos + 7)), static_cast<int>(be16(data, pos + 5))};
+            }
+            pos += 2 + length;
+        }
+        return std::nullopt;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_IMAGE_SIZE_H__
@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_LUA_BRIDGE_H__
+#define __M2E_BRIDGE_LUA_BRIDGE_H__
+
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+#include <lua.hpp>
+
+#include "m2e_aliases.h"
+
+
+/*
+Passing payloads between C++ and Lua without a text round trip.
+
+A payload view is a read-only userdata over the raw payload bytes, valid only
+while the Lua call it is passed to runs. The JSON bridge builds Lua tables from
+a decoded json and back; JSON null is the light userdata NULL, which is also
+cjson.null.
+*/
+
+namespace lua_bridge
+{
+    inline constexpr char const * PAYLOAD_VIEW = "m2e.payload_view";
+    inline constexpr int MAX_DEPTH = 128;
+
+    struct PayloadView{
+        char const * data;
+        size_t size;
+        bool valid;
+    };
+
+    inline PayloadView & check_view(lua_State * L)
+    {
+        auto view = static_cast<PayloadView *>(luaL_checkudata(L, 1, PAYLOAD_VIEW));
+        if( ! view->valid ){
+            luaL_error(L, "payload view is used after convert returned");
+        }
+        return * view;
+    }
+
+    // Lua string index rules: 1-based, negative from the end
+    inline size_t position(lua_Integer pos, size_t size)
+    {
+        if( pos > 0 ) return static_cast<size_t>(pos);
+        if( pos == 0 ) return 1;
+        if( static_cast<size_t>(-pos) > size ) return 1;
+        return size + static_cast<size_t>(pos) + 1;
+    }
+
+    inline int view_len(lua_State * L)
+    {
+        lua_pushinteger(L, static_cast<lua_Integer>(check_view(L).size));
+        return 1;
+    }
+
+    inline int view_tostring(lua_State * L)
+    {
+        PayloadView const & view = check_view(L);
+        lua_pushlstring(L, view.data, view.size);
+        return 1;
+    }
+
+    // view:sub(i [, j]), as string.sub
+    inline int view_sub(lua_State * L)
+    {
+        PayloadView const & view = check_view(L);
+        size_t first = position(luaL_checkinteger(L, 2), view.size);
+        size_t last = position(luaL_optinteger(L, 3, -1), view.size);
+        if( last > view.size ) last = view.size;
+        if( first > last ){
+            lua_pushliteral(L, "");
+        }else{
+            lua_pushlstring(L, view.data + first - 1, last - first + 1);
+        }
+        return 1;
+    }
+
+    // view:byte([i]), the byte value at i
+    inline int view_byte(lua_State * L)
+    {
+        PayloadView const & view = check_view(L);
+        size_t pos = position(luaL_optinteger(L, 2, 1), view.size);
+        if( pos > view.size ) return 0;
+        lua_pushinteger(L, static_cast<unsigned char>(view.data[pos - 1]));
+        return 1;
+    }
+
+    // view:find(text [, init]), plain search returning the start and end positions
+    inline int view_find(lua_State * L)
+    {
+        PayloadView const & view = check_view(L);
+        size_t len;
+        char const * text = luaL_checklstring(L, 2, & len);
+        size_t init = position(luaL_optinteger(L, 3, 1), view.size);
+        if( init > view.size + 1 ){
+            lua_pushnil(L);
+            return 1;
+        }
+        std::string_view haystack(view.data, view.size);
+        size_t found = haystack.find(std::string_view(text, len), init - 1);
+        if( found == std::string_view::npos ){
+            lua_pushnil(L);
+            return 1;
+        }
+        lua_pushinteger(L, static_cast<lua_Integer>(found + 1));
+        lua_pushinteger(L, static_cast<lua_Integer>(found + len));
+        return 2;
+    }
+
+    // Registers the payload view metatable, once per state
+    inline void register_payload_view(lua_State * L)
+    {
+        static luaL_Reg const methods[] = {
+            {"sub", view_sub},
+            {"byte", view_byte},
+            {"find", view_find},
+            {"tostring", view_tostring},
+            {nullptr, nullptr}
+        };
+        luaL_newmetatable(L, PAYLOAD_VIEW);
+        lua_pushcfunction(L, view_len);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, view_tostring);
+        lua_setfield(L, -2, "__tostring");
+        luaL_newlib(L, methods);
+        lua_setfield(L, -2, "__index");
+        lua_pop(L, 1);
+    }
+
+    // Pushes a view of data; invalidate it once the call returns, Lua may keep a reference
+    inline PayloadView * push_payload_view(lua_State * L, std::string_view data)
+    {
+        auto view = static_cast<PayloadView *>(lua_newuserdata(L, sizeof(PayloadView)));
+        view->data = data.data();
+        view->size = data.size();
+        view->valid = true;
+        luaL_setmetatable(L, PAYLOAD_VIEW);
+        return view;
+    }
+
+    inline void invalidate(PayloadView * view)
+    {
+        view->valid = false;
+    }
+
+    inline void push_json(lua_State * L, json const & j, int depth = 0)
+    {
+        // Called outside of a protected call, a Lua error would abort
+        if( depth > MAX_DEPTH || ! lua_checkstack(L, 3) ){
+            throw std::runtime_error("JSON is nested too deep!");
+        }
+        switch( j.type() )
+        {
+            case json::value_t::object:
+                lua_createtable(L, 0, static_cast<int>(j.size()));
+                for( auto it = j.begin(); it != j.end(); ++it ){
+                    lua_pushlstring(L, it.key().data(), it.key().size());
+                    push_json(L, it.value(), depth + 1);
+                    lua_rawset(L, -3);
+                }
+                break;
+            case json::value_t::array: {
+                lua_createtable(L, static_cast<int>(j.size()), 0);
+                lua_Integer ix = 1;
+                for( auto const & item : j ){
+                    push_json(L, item, depth + 1);
+                    lua_rawseti(L, -2, ix++);
+                }
+                break;
+            }
+            case json::value_t::string: {
+                auto const & str = j.get_ref<string const &>();
+                lua_pushlstring(L, str.data(), str.size());
+                break;
+            }
+            case json::value_t::binary: {
+                auto const & bin = j.get_binary();
+                lua_pushlstring(L, reinterpret_cast<char const *>(bin.data()), bin.size());
+                break;
+            }
+            case json::value_t::boolean:
+                lua_pushboolean(L, j.get<bool>());
+                break;
+            case json::value_t::number_integer:
+                lua_pushinteger(L, static_cast<lua_Integer>(j.get<int64_t>()));
+                break;
+            case json::value_t::number_unsigned:
+                lua_pushinteger(L, static_cast<lua_Integer>(j.get<uint64_t>()));
+                break;
+            case json::value_t::number_float:
+                lua_pushnumber(L, j.get<double>());
+                break;
+            default:
+                lua_pushlightuserdata(L, nullptr);
+        }
+    }
+
+    // A table with keys 1..n only is an array, any other table an object
+    inline json to_json(lua_State * L, int idx, int depth = 0)
+    {
+        if( depth > MAX_DEPTH || ! lua_checkstack(L, 3) ){
+            throw std::runtime_error("Lua table is nested too deep!");
+        }
+        idx = lua_absindex(L, idx);
+        switch( lua_type(L, idx) )
+        {
+            case LUA_TTABLE: {
+                size_t len = lua_rawlen(L, idx);
+                size_t count = 0;
+                bool is_array = len > 0;
+                lua_pushnil(L);
+                while( lua_next(L, idx) ){
+                    ++count;
+                    if( ! lua_isinteger(L, -2) ) is_array = false;
+                    lua_pop(L, 1);
+                }
+                is_array = is_array && count == len;
+
+                if( is_array ){
+                    json arr = json::array();
+                    for( size_t i = 1; i <= len; ++i ){
+                        lua_rawgeti(L, idx, static_cast<lua_Integer>(i));
+                        arr.push_back(to_json(L, -1, depth + 1));
+                        lua_pop(L, 1);
+                    }
+                    return arr;
+                }
+                json obj = json::object();
+                lua_pushnil(L);
+                while( lua_next(L, idx) ){
+                    // lua_tolstring would change a number key in place and break lua_next
+                    lua_pushvalue(L, -2);
+                    size_t klen;
+                    char const * key = lua_tolstring(L, -1, & klen);
+                    if( key == nullptr ) throw std::runtime_error("Lua table key is not a string!");
+                    obj[string(key, klen)] = to_json(L, -2, depth + 1);
+                    lua_pop(L, 2);
+                }
+                return obj;
+            }
+            case LUA_TSTRING: {
+                size_t len;
+                char const * str = lua_tolstring(L, idx, & len);
+                return string(str, len);
+            }
+            case LUA_TNUMBER:
+                if( lua_isinteger(L, idx) ) return static_cast<int64_t>(lua_tointeger(L, idx));
+                return lua_tonumber(L, idx);
+            case LUA_TBOOLEAN:
+                return static_cast<bool>(lua_toboolean(L, idx));
+            case LUA_TNIL:
+                return nullptr;
+            case LUA_TLIGHTUSERDATA:
+                if( lua_touserdata(L, idx) == nullptr ) return nullptr;
+                [[fallthrough]];
+            default:
+                throw std::runtime_error(fmt::format(
+                    "Lua {} can not be converted to JSON!", lua_typename(L, lua_type(L, idx))));
+        }
+    }
+}
+
+
+#endif  // __M2E_BRIDGE_LUA_BRIDGE_H__
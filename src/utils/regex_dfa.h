@@ -0,0 +1,552 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_REGEX_DFA_H__
+#define __M2E_BRIDGE_REGEX_DFA_H__
+
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/*
+Regular expression search in time linear in the text, without backtracking.
+
+The pattern is compiled once into a Thompson NFA over byte classes. Searching
+runs a DFA whose states are built lazily from the NFA and cached, as RE2 does,
+so repeated searches cost one table lookup per byte. The cache is bounded by a
+byte budget and dropped when it is exhausted, then rebuilt from the current
+state; memory stays bounded whatever the pattern and the texts are.
+
+Syntax is the common subset of ECMAScript and RE2: literals, ., [...] and [^...]
+classes with ranges, \d \w \s and their negations, escapes, groups (...) and
+(?:...), alternation, * + ? {m} {m,} {m,n} (lazy forms are accepted and match
+the same), ^ and $ anchoring at the ends of the text. Back references and look
+arounds, which require backtracking, are rejected.
+
+A DfaRegex is not thread safe, searching fills its cache.
+*/
+class DfaRegex
+{
+public:
+    static constexpr size_t MAX_NFA_STATES {20000};
+    static constexpr unsigned MAX_REPEAT {1000};
+    static constexpr size_t DEFAULT_CACHE_BYTES {1 << 20};
+
+    explicit DfaRegex(std::string_view pattern, bool case_insensitive = false,
+                      size_t cache_bytes = DEFAULT_CACHE_BYTES):
+        case_insensitive_(case_insensitive), cache_bytes_(cache_bytes)
+    {
+        Parser parser(* this, pattern);
+        auto root = parser.parse();
+        nfa_.push_back({NState::MATCH});
+        start_ = emit(* root, 0);
+        build_classes();
+        mid_start_ = closure({start_}, false);
+        reset_cache();
+    }
+
+    // True if the pattern matches anywhere in text
+    bool search(std::string_view text) const
+    {
+        int32_t s = begin_state_;
+        if( s < 0 ) s = begin_state_ = intern(closure({start_}, true));
+        for( size_t pos = 0; pos < text.size(); ++pos )
+        {
+            DState const & ds = dstates_[s];
+            if( ds.match ) return true;
+            if( ds.dead ) return false;
+            uint16_t cls = classes_[static_cast<unsigned char>(text[pos])];
+            int32_t t = trans_[s * n_classes_ + cls];
+            if( t < 0 ) t = step(s, cls);
+            s = t;
+        }
+        return dstates_[s].match || dstates_[s].match_at_end;
+    }
+
+    // Number of DFA states built since the cache was last dropped
+    size_t cached_states() const
+    {
+        return dstates_.size();
+    }
+
+private:
+    struct NState{
+        enum Kind : uint8_t { MATCH, SET, SPLIT, BEGIN, END };
+        Kind kind;
+        uint32_t set {0};
+        int32_t out {-1};
+        int32_t out1 {-1};
+    };
+
+    struct Node{
+        enum Kind { SET, EMPTY, CONCAT, ALT, REPEAT, BEGIN, END };
+        Kind kind;
+        uint32_t set {0};
+        unsigned min {0};
+        unsigned max {0};  // UNBOUNDED for no limit
+        std::vector<std::unique_ptr<Node>> kids;
+    };
+
+    struct DState{
+        std::vector<int32_t> nfa;
+        bool match {false};
+        bool match_at_end {false};
+        bool dead {false};
+    };
+
+    static constexpr unsigned UNBOUNDED = ~0u;
+
+    bool case_insensitive_;
+    size_t cache_bytes_;
+    std::vector<std::bitset<256>> sets_;
+    std::vector<NState> nfa_;
+    int32_t start_ {0};
+    std::array<uint16_t, 256> classes_ {};
+    std::vector<unsigned char> class_bytes_;  // a representative byte of each class
+    size_t n_classes_ {1};
+    std::vector<int32_t> mid_start_;
+
+    mutable std::vector<DState> dstates_;
+    mutable std::vector<int32_t> trans_;
+    mutable std::map<std::vector<int32_t>, int32_t> index_;
+    mutable size_t cache_used_ {0};
+    mutable int32_t begin_state_ {-1};
+    mutable size_t flushes_ {0};
+
+    class Parser{
+        DfaRegex & re_;
+        std::string_view p_;
+        size_t pos_ {0};
+    public:
+        Parser(DfaRegex & re, std::string_view pattern): re_(re), p_(pattern) {}
+
+        std::unique_ptr<Node> parse(){
+            auto node = alternation();
+            if( pos_ < p_.size() ) fail("unmatched )");
+            return node;
+        }
+
+    private:
+        [[noreturn]] void fail(std::string const & what) const{
+            throw std::invalid_argument("Invalid regex at " + std::to_string(pos_) + ": " + what);
+        }
+
+        bool more() const{ return pos_ < p_.size(); }
+        char peek() const{ return p_[pos_]; }
+
+        std::unique_ptr<Node> make(Node::Kind kind){
+            auto node = std::make_unique<Node>();
+            node->kind = kind;
+            return node;
+        }
+
+        std::unique_ptr<Node> alternation(){
+            auto first = concatenation();
+            if( ! more() || peek() != '|' ) return first;
+            auto alt = make(Node::ALT);
+            alt->kids.push_back(std::move(first));
+            while( more() && peek() == '|' ){
+                ++pos_;
+                alt->kids.push_back(concatenation());
+            }
+            return alt;
+        }
+
+        std::unique_ptr<Node> concatenation(){
+            auto cat = make(Node::CONCAT);
+            while( more() && peek() != '|' && peek() != ')' ){
+                cat->kids.push_back(repetition());
+            }
+            if( cat->kids.empty() ) return make(Node::EMPTY);
+            if( cat->kids.size() == 1 ) return std::move(cat->kids[0]);
+            return cat;
+        }
+
+        std::unique_ptr<Node> repetition(){
+            auto node = atom();
+            while( more() ){
+                unsigned min, max;
+                char c = peek();
+                if( c == '*' ){ min = 0; max = UNBOUNDED; ++pos_; }
+                else if( c == '+' ){ min = 1; max = UNBOUNDED; ++pos_; }
+                else if( c == '?' ){ min = 0; max = 1; ++pos_; }
+                else if( c == '{' && counted(min, max) ){}
+                else break;
+                if( node->kind == Node::BEGIN || node->kind == Node::END ) fail("nothing to repeat");
+                // Lazy and greedy quantifiers find the same matches
+                if( more() && peek() == '?' ) ++pos_;
+                auto rep = make(Node::REPEAT);
+                rep->min = min;
+                rep->max = max;
+                rep->kids.push_back(std::move(node));
+                node = std::move(rep);
+            }
+            return node;
+        }
+
+        // {m}, {m,} or {m,n}; a brace which starts none of them is a literal
+        bool counted(unsigned & min, unsigned & max){
+            size_t save = pos_++;
+            auto number = [this](unsigned & n){
+                size_t start = pos_;
+                n = 0;
+                while( more() && peek() >= '0' && peek() <= '9' ){
+                    n = n * 10 + (peek() - '0');
+                    if( n > MAX_REPEAT ) fail("repetition count is too large");
+                    ++pos_;
+                }
+                return pos_ > start;
+            };
+            if( ! number(min) ){ pos_ = save; return false; }
+            max = min;
+            if( more() && peek() == ',' ){
+                ++pos_;
+                if( ! number(max) ) max = UNBOUNDED;
+            }
+            if( ! more() || peek() != '}' ){ pos_ = save; return false; }
+            ++pos_;
+            if( max < min ) fail("repetition range is reversed");
+            return true;
+        }
+
+        std::unique_ptr<Node> atom(){
+            char c = p_[pos_++];
+            switch( c ){
+                case '(': {
+                    if( more() && peek() == '?' ){
+                        if( pos_ + 1 < p_.size() && p_[pos_ + 1] == ':' ) pos_ += 2;
+                        else fail("unsupported group");
+                    }
+                    auto node = alternation();
+                    if( ! more() || peek() != ')' ) fail("missing )");
+                    ++pos_;
+                    return node;
+                }
+                case ')': fail("unmatched )");
+                case '*': case '+': case '?': fail("nothing to repeat");
+                case '^': return make(Node::BEGIN);
+                case '$': return make(Node::END);
+                case '.': {
+                    std::bitset<256> set;
+                    set.set();
+                    set.reset('\n');
+                    set.reset('\r');
+                    return set_node(set);
+                }
+                case '[': return set_node(char_class());
+                case '\\': {
+                    std::bitset<256> set;
+                    escape(set, false);
+                    return set_node(set);
+                }
+                default: {
+                    std::bitset<256> set;
+                    set.set(static_cast<unsigned char>(c));
+                    return set_node(set);
+                }
+            }
+        }
+
+        // Adds the other case of every letter, case-insensitive patterns only
+        void fold_case(std::bitset<256> & set){
+            if( ! re_.case_insensitive_ ) return;
+            for( unsigned c = 'a'; c <= 'z'; ++c ){
+                if( set.test(c) || set.test(c - 'a' + 'A') ){
+                    set.set(c);
+                    set.set(c - 'a' + 'A');
+                }
+            }
+        }
+
+        std::unique_ptr<Node> set_node(std::bitset<256> set){
+            fold_case(set);
+            auto node = make(Node::SET);
+            node->set = static_cast<uint32_t>(re_.sets_.size());
+            re_.sets_.push_back(set);
+            return node;
+        }
+
+        std::bitset<256> char_class(){
+            std::bitset<256> set;
+            bool negated = more() && peek() == '^';
+            if( negated ) ++pos_;
+            bool first = true;
+            while( true ){
+                if( ! more() ) fail("missing ]");
+                char c = p_[pos_++];
+                if( c == ']' && ! first ) break;
+                first = false;
+                int lo;
+                if( c == '\\' ){
+                    std::bitset<256> escaped;
+                    lo = escape(escaped, true);
+                    if( lo < 0 ){
+                        set |= escaped;
+                        continue;
+                    }
+                }else{
+                    lo = static_cast<unsigned char>(c);
+                }
+                int hi = lo;
+                if( pos_ + 1 < p_.size() && peek() == '-' && p_[pos_ + 1] != ']' ){
+                    ++pos_;
+                    char h = p_[pos_++];
+                    if( h == '\\' ){
+                        std::bitset<256> escaped;
+                        hi = escape(escaped, true);
+                        if( hi < 0 ) fail("class in range");
+                    }else{
+                        hi = static_cast<unsigned char>(h);
+                    }
+                    if( hi < lo ) fail("range is reversed");
+                }
+                for( int b = lo; b <= hi; ++b ) set.set(b);
+            }
+            // [^a] must not match A either, fold the letters before negating
+            fold_case(set);
+            if( negated ) set.flip();
+            return set;
+        }
+
+        // Sets the escaped class into set and returns -1, or returns the escaped byte
+        int escape(std::bitset<256> & set, bool in_class){
+            if( ! more() ) fail("trailing \\");
+            char c = p_[pos_++];
+            auto add_range = [&set](int lo, int hi){ for( int b = lo; b <= hi; ++b ) set.set(b); };
+            switch( c ){
+                case 'd': add_range('0', '9'); return -1;
+                case 'D': add_range('0', '9'); set.flip(); return -1;
+                case 'w': add_range('0', '9'); add_range('a', 'z'); add_range('A', 'Z'); set.set('_'); return -1;
+                case 'W': add_range('0', '9'); add_range('a', 'z'); add_range('A', 'Z'); set.set('_'); set.flip(); return -1;
+                case 's': for( char s : {' ', '\t', '\n', '\r', '\f', '\v'} ) set.set(s); return -1;
+                case 'S': for( char s : {' ', '\t', '\n', '\r', '\f', '\v'} ) set.set(s); set.flip(); return -1;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'f': c = '\f'; break;
+                case 'v': c = '\v'; break;
+                case '0': c = '\0'; break;
+                case 'x': {
+                    if( pos_ + 2 > p_.size() ) fail("incomplete \\x");
+                    int value = 0;
+                    for( int i = 0; i < 2; ++i ){
+                        char h = p_[pos_++];
+                        value <<= 4;
+                        if( h >= '0' && h <= '9' ) value |= h - '0';
+                        else if( h >= 'a' && h <= 'f' ) value |= h - 'a' + 10;
+                        else if( h >= 'A' && h <= 'F' ) value |= h - 'A' + 10;
+                        else fail("invalid \\x");
+                    }
+                    c = static_cast<char>(value);
+                    break;
+                }
+                default:
+                    if( (c >= '1' && c <= '9') || c == 'k' ) fail("back references are not supported");
+                    if( (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ){
+                        if( ! in_class && (c == 'b' || c == 'B') ) fail("word boundaries are not supported");
+                        fail(std::string("unknown escape \\") + c);
+                    }
+            }
+            set.set(static_cast<unsigned char>(c));
+            return static_cast<unsigned char>(c);
+        }
+    };
+
+    int32_t add(NState state){
+        if( nfa_.size() >= MAX_NFA_STATES ) throw std::invalid_argument("Regex is too large");
+        nfa_.push_back(state);
+        return static_cast<int32_t>(nfa_.size() - 1);
+    }
+
+    // Compiles node to continue with the state next, returns the entry state
+    int32_t emit(Node const & node, int32_t next){
+        switch( node.kind ){
+            case Node::SET: return add({NState::SET, node.set, next});
+            case Node::EMPTY: return next;
+            case Node::BEGIN: return add({NState::BEGIN, 0, next});
+            case Node::END: return add({NState::END, 0, next});
+            case Node::CONCAT:
+                for( auto it = node.kids.rbegin(); it != node.kids.rend(); ++it ){
+                    next = emit(** it, next);
+                }
+                return next;
+            case Node::ALT: {
+                int32_t entry = emit(* node.kids.back(), next);
+                for( auto it = node.kids.rbegin() + 1; it != node.kids.rend(); ++it ){
+                    entry = add({NState::SPLIT, 0, emit(** it, next), entry});
+                }
+                return entry;
+            }
+            case Node::REPEAT: {
+                Node const & kid = * node.kids[0];
+                int32_t tail = next;
+                if( node.max == UNBOUNDED ){
+                    int32_t loop = add({NState::SPLIT, 0, -1, next});
+                    nfa_[loop].out = emit(kid, loop);
+                    tail = loop;
+                }else{
+                    for( unsigned i = node.min; i < node.max; ++i ){
+                        tail = add({NState::SPLIT, 0, emit(kid, tail), next});
+                    }
+                }
+                for( unsigned i = 0; i < node.min; ++i ){
+                    tail = emit(kid, tail);
+                }
+                return tail;
+            }
+        }
+        return next;
+    }
+
+    // Bytes which every set treats alike share a class
+    void build_classes(){
+        std::vector<uint16_t> cls(256, 0);
+        n_classes_ = 1;
+        for( auto const & set : sets_ ){
+            std::map<std::pair<uint16_t, bool>, uint16_t> refined;
+            for( unsigned b = 0; b < 256; ++b ){
+                auto key = std::make_pair(cls[b], static_cast<bool>(set.test(b)));
+                auto it = refined.try_emplace(key, static_cast<uint16_t>(refined.size())).first;
+                cls[b] = it->second;
+            }
+            n_classes_ = refined.size();
+        }
+        class_bytes_.assign(n_classes_, 0);
+        for( int b = 255; b >= 0; --b ){
+            classes_[b] = cls[b];
+            class_bytes_[cls[b]] = static_cast<unsigned char>(b);
+        }
+    }
+
+    // States reachable without consuming a byte; END states are kept unresolved
+    std::vector<int32_t> closure(std::vector<int32_t> const & from, bool at_begin) const{
+        std::vector<int32_t> result;
+        std::vector<bool> seen(nfa_.size(), false);
+        std::vector<int32_t> stack(from.rbegin(), from.rend());
+        while( ! stack.empty() ){
+            int32_t s = stack.back();
+            stack.pop_back();
+            if( s < 0 || seen[s] ) continue;
+            seen[s] = true;
+            NState const & ns = nfa_[s];
+            switch( ns.kind ){
+                case NState::SPLIT:
+                    stack.push_back(ns.out1);
+                    stack.push_back(ns.out);
+                    break;
+                case NState::BEGIN:
+                    if( at_begin ) stack.push_back(ns.out);
+                    break;
+                default:
+                    result.push_back(s);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    bool accepts_at_end(std::vector<int32_t> const & states) const{
+        std::vector<int32_t> pending;
+        for( int32_t s : states ){
+            if( nfa_[s].kind == NState::END ) pending.push_back(nfa_[s].out);
+        }
+        std::vector<bool> seen(nfa_.size(), false);
+        while( ! pending.empty() ){
+            int32_t s = pending.back();
+            pending.pop_back();
+            if( seen[s] ) continue;
+            seen[s] = true;
+            NState const & ns = nfa_[s];
+            switch( ns.kind ){
+                case NState::MATCH: return true;
+                case NState::SPLIT: pending.push_back(ns.out); pending.push_back(ns.out1); break;
+                case NState::END: pending.push_back(ns.out); break;
+                default: break;
+            }
+        }
+        return false;
+    }
+
+    void reset_cache() const{
+        dstates_.clear();
+        trans_.clear();
+        index_.clear();
+        cache_used_ = 0;
+        begin_state_ = -1;
+        ++flushes_;
+    }
+
+    int32_t intern(std::vector<int32_t> && states) const{
+        auto it = index_.find(states);
+        if( it != index_.end() ) return it->second;
+
+        size_t cost = n_classes_ * sizeof(int32_t) + 2 * states.size() * sizeof(int32_t) + 64;
+        if( cache_used_ + cost > cache_bytes_ && ! dstates_.empty() ){
+            reset_cache();
+        }
+        cache_used_ += cost;
+
+        DState ds;
+        ds.match = std::any_of(states.begin(), states.end(),
+            [this](int32_t s){ return nfa_[s].kind == NState::MATCH; });
+        ds.match_at_end = ds.match || accepts_at_end(states);
+        ds.dead = states.empty();
+        ds.nfa = states;
+        int32_t id = static_cast<int32_t>(dstates_.size());
+        dstates_.push_back(std::move(ds));
+        trans_.resize(dstates_.size() * n_classes_, -1);
+        index_.emplace(std::move(states), id);
+        return id;
+    }
+
+    int32_t step(int32_t from, uint16_t cls) const{
+        unsigned char byte = class_bytes_[cls];
+        std::vector<int32_t> next;
+        for( int32_t s : dstates_[from].nfa ){
+            NState const & ns = nfa_[s];
+            if( ns.kind == NState::SET && sets_[ns.set].test(byte) ) next.push_back(ns.out);
+        }
+        // Unanchored search, a match may start at every position
+        next.insert(next.end(), mid_start_.begin(), mid_start_.end());
+
+        size_t flushes = flushes_;
+        int32_t to = intern(closure(next, false));
+        // Unless the cache was dropped meanwhile, remember the transition
+        if( flushes == flushes_ ) trans_[from * n_classes_ + cls] = to;
+        return to;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_REGEX_DFA_H__
@@ -0,0 +1,310 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_SPSC_QUEUE_H__
+#define __M2E_BRIDGE_SPSC_QUEUE_H__
+
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include "event_count.h"
+
+
+// Not std::hardware_destructive_interference_size: GCC warns that its value
+// depends on -mtune, and 64 is right for every target we ship to.
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+
+/*
+Bounded lock-free queue for exactly one producer thread and one consumer thread.
+
+Elements are moved in and moved out. When the queue is empty (full), the consumer
+(producer) spins for a short while and then sleeps on an EventCount, so the other
+side only pays for a wakeup if somebody actually went to sleep.
+
+Besides the element capacity the queue may be limited by a byte budget: every
+push carries the size of the element and the push fails while the budget is
+exhausted. A single element larger than the whole budget is still accepted
+into an empty queue, otherwise it could never get through.
+
+Each slot carries a sequence number, so the head is claimed with a CAS. This
+lets the producer take the oldest element out with evict() while the consumer
+is popping, which is what the drop-oldest overflow policy needs.
+
+In non-blocking mode pop() on an empty queue throws std::underflow_error and
+push() on a full queue throws std::overflow_error, same as TSQueue.
+*/
+
+template <typename T>
+class SPSCQueue
+{
+    static constexpr unsigned SPIN_COUNT = 64;
+    static constexpr unsigned PAUSE_COUNT = 16;
+
+    struct Slot
+    {
+        std::atomic<size_t> seq;
+        size_t nbytes {0};
+        T value {};
+    };
+
+    size_t capacity_;
+    size_t mask_;
+    size_t byte_capacity_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // Consumer side (the producer touches it only in evict())
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_ {0};
+
+    // Producer side
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_ {0};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> bytes_ {0};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> blocking_ {true};
+    EventCount not_empty_;
+    EventCount not_full_;
+
+    static void backoff(unsigned spin)
+    {
+        if( spin < PAUSE_COUNT ){
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }else{
+            std::this_thread::yield();
+        }
+    }
+
+    static size_t round_up(size_t v)
+    {
+        size_t p = 1;
+        while( p < v ) p <<= 1;
+        return p;
+    }
+
+public:
+    // byte_capacity == 0 means the queue is limited by the element count only
+    explicit SPSCQueue(size_t capacity = 1024, bool blocking = true, size_t byte_capacity = 0)
+        :capacity_(round_up(capacity > 0 ? capacity : 1)),
+         mask_(capacity_ - 1),
+         byte_capacity_(byte_capacity),
+         slots_(new Slot[capacity_])
+    {
+        for( size_t i = 0; i < capacity_; ++i ){
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        blocking_ = blocking;
+    }
+
+    SPSCQueue(SPSCQueue const &) = delete;
+    SPSCQueue & operator=(SPSCQueue const &) = delete;
+
+    ~SPSCQueue()
+    {
+        set_non_blocking();
+    }
+
+    void set_non_blocking()
+    {
+        blocking_.store(false, std::memory_order_seq_cst);
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    void set_blocking()
+    {
+        blocking_.store(true, std::memory_order_seq_cst);
+    }
+
+    bool is_blocking() const
+    {
+        return blocking_.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    size_t byte_capacity() const
+    {
+        return byte_capacity_;
+    }
+
+    size_t size() const
+    {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        // Both are loaded separately, the head may have overtaken the stale tail
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t bytes() const
+    {
+        return bytes_.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Producer only. On failure `value` is left untouched.
+    bool try_push(T && value, size_t nbytes = 0)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        Slot & slot = slots_[tail & mask_];
+        if( slot.seq.load(std::memory_order_acquire) != tail ) return false;
+        if( byte_capacity_ > 0 && nbytes > 0 ){
+            size_t used = bytes_.load(std::memory_order_acquire);
+            if( used > 0 && used + nbytes > byte_capacity_ ) return false;
+        }
+        slot.value = std::move(value);
+        slot.nbytes = nbytes;
+        bytes_.fetch_add(nbytes, std::memory_order_relaxed);
+        slot.seq.store(tail + 1, std::memory_order_release);
+        tail_.store(tail + 1, std::memory_order_release);
+        not_empty_.notify_all();
+        return true;
+    }
+
+    // Producer only
+    void push(T && value, size_t nbytes = 0)
+    {
+        for( unsigned spin = 0; ; ++spin ){
+            if( try_push(std::move(value), nbytes) ) return;
+            if( ! blocking_.load(std::memory_order_acquire) ){
+                throw std::overflow_error("Queue is full!");
+            }
+            if( spin < SPIN_COUNT ){
+                backoff(spin);
+                continue;
+            }
+            auto key = not_full_.prepare_wait();
+            if( ! full(nbytes) || ! blocking_.load(std::memory_order_seq_cst) ){
+                not_full_.cancel_wait();
+            }else{
+                not_full_.wait(key);
+            }
+        }
+    }
+
+    void push(T const & value, size_t nbytes = 0)
+    {
+        T copy = value;
+        push(std::move(copy), nbytes);
+    }
+
+    // Consumer only
+    std::optional<T> try_pop()
+    {
+        return take();
+    }
+
+    // Producer only. Removes the oldest element to make room for a new one.
+    // Returns nothing if the consumer has emptied the queue in the meantime.
+    std::optional<T> evict()
+    {
+        return take();
+    }
+
+    // Consumer only
+    T pop()
+    {
+        for( unsigned spin = 0; ; ++spin ){
+            if( auto value = try_pop() ) return std::move(* value);
+            if( ! blocking_.load(std::memory_order_acquire) ){
+                throw std::underflow_error("No messages in queue!");
+            }
+            if( spin < SPIN_COUNT ){
+                backoff(spin);
+                continue;
+            }
+            wait();
+        }
+    }
+
+    // Consumer only. Sleeps until the queue is not empty, interrupt() is called
+    // or the queue is switched to non-blocking mode. `ready` lets the consumer
+    // add its own wake-up condition, which is re-checked after registering as
+    // a waiter, so an interrupt() issued right before wait() is not lost.
+    void wait()
+    {
+        wait([]{ return false; });
+    }
+
+    template<typename Pred>
+    void wait(Pred && ready)
+    {
+        auto key = not_empty_.prepare_wait();
+        if( ! empty() || ready() || ! blocking_.load(std::memory_order_seq_cst) ){
+            not_empty_.cancel_wait();
+        }else{
+            not_empty_.wait(key);
+        }
+    }
+
+    // Wakes up the consumer sleeping in wait()
+    void interrupt()
+    {
+        not_empty_.notify_all();
+    }
+
+private:
+    std::optional<T> take()
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        for( ;; ){
+            Slot & slot = slots_[head & mask_];
+            if( slot.seq.load(std::memory_order_acquire) != head + 1 ) return std::nullopt;
+            if( head_.compare_exchange_weak(head, head + 1,
+                    std::memory_order_acq_rel, std::memory_order_relaxed) ){
+                std::optional<T> value {std::move(slot.value)};
+                // Do not keep moved-from resources (e.g. shared_ptr control blocks) in the ring
+                slot.value = T();
+                bytes_.fetch_sub(slot.nbytes, std::memory_order_relaxed);
+                slot.seq.store(head + capacity_, std::memory_order_release);
+                not_full_.notify_all();
+                return value;
+            }
+        }
+    }
+
+    bool full(size_t nbytes) const
+    {
+        if( size() >= capacity_ ) return true;
+        if( byte_capacity_ == 0 || nbytes == 0 ) return false;
+        size_t used = bytes_.load(std::memory_order_acquire);
+        return used > 0 && used + nbytes > byte_capacity_;
+    }
+};
+
+
+#endif  // __M2E_BRIDGE_SPSC_QUEUE_H__
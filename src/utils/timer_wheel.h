@@ -0,0 +1,401 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+Copyright (c) 2026 Pluraf Embedded AB <code@pluraf.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the “Software”), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to
+do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+*/
+
+
+#ifndef __M2E_BRIDGE_TIMER_WHEEL_H__
+#define __M2E_BRIDGE_TIMER_WHEEL_H__
+
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+
+class TimerGroup;
+
+
+/*
+Process-wide hierarchical timer wheel (Varghese & Lauck).
+
+Time is counted in ticks of a fixed resolution. LEVELS wheels of SLOTS slots each
+cover SLOTS, SLOTS^2, ... ticks ahead. A timer goes to the lowest wheel whose range
+covers its delay; when a lower wheel wraps around, the next slot of the wheel above
+is cascaded down. Insert, cancel and expire are O(1), so the wheel holds any number
+of pending timers at a constant cost per timer.
+
+Callbacks run one at a time on the timer thread and must be short: they should
+schedule a task or push to a queue, not do the work themselves. cancel() called
+while the callback runs waits for it to return, so after a successful cancel()
+or TimerGroup::close() nothing the callback points to is in use anymore.
+*/
+
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+
+    static constexpr TimerId INVALID_TIMER = 0;
+    static constexpr unsigned SLOT_BITS = 8;
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+    static constexpr unsigned LEVELS = 4;
+    // Longer delays are clamped, with 1 ms ticks it is about 49 days
+    static constexpr uint64_t MAX_TICKS = (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+private:
+    friend class TimerGroup;
+
+    struct Link
+    {
+        Link * prev {this};
+        Link * next {this};
+
+        bool empty() const { return next == this; }
+
+        void unlink()
+        {
+            prev->next = next;
+            next->prev = prev;
+            prev = next = this;
+        }
+
+        void push_back(Link * link)
+        {
+            link->prev = prev;
+            link->next = this;
+            prev->next = link;
+            prev = link;
+        }
+    };
+
+    // A timer is linked into a slot and into its group, two base classes tell the links apart
+    struct SlotLink: Link {};
+    struct GroupLink: Link {};
+
+    struct Timer: SlotLink, GroupLink
+    {
+        TimerId id;
+        uint64_t expires;
+        TimerGroup * group;
+        std::function<void()> func;
+    };
+
+    static Timer * from_slot(Link * link) { return static_cast<Timer *>(static_cast<SlotLink *>(link)); }
+
+    std::chrono::milliseconds resolution_;
+    Clock::time_point origin_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    SlotLink wheels_[LEVELS][SLOTS];
+    SlotLink expired_;
+    std::unordered_map<TimerId, Timer *> timers_;
+    uint64_t now_ {0};  // next tick to process
+    uint64_t wake_tick_ {UINT64_MAX};  // tick the timer thread sleeps until
+    TimerId next_id_ {1};
+    TimerId running_id_ {INVALID_TIMER};
+    TimerGroup * running_group_ {nullptr};
+    bool stopping_ {false};
+    std::thread thread_;
+
+public:
+    explicit TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(1))
+        :resolution_(std::max(resolution, std::chrono::milliseconds(1))),
+         origin_(Clock::now())
+    {
+        thread_ = std::thread(& TimerWheel::run, this);
+    }
+
+    TimerWheel(TimerWheel const &) = delete;
+    TimerWheel & operator=(TimerWheel const &) = delete;
+
+    ~TimerWheel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        wake_cv_.notify_all();
+        thread_.join();
+        for( auto & [id, timer] : timers_ ){
+            delete timer;
+        }
+    }
+
+    static TimerWheel & get_instance()
+    {
+        static TimerWheel instance;
+        return instance;
+    }
+
+    // Runs `func` on the timer thread not earlier than after `delay`
+    TimerId schedule(std::chrono::milliseconds delay, std::function<void()> func)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return add(lock, delay, std::move(func), nullptr);
+    }
+
+    // Returns false if the timer already fired or was cancelled
+    bool cancel(TimerId id)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        auto it = timers_.find(id);
+        if( it == timers_.end() ){
+            if( running_id_ == id && ! on_timer_thread() ){
+                done_cv_.wait(lock, [this, id]{ return running_id_ != id; });
+            }
+            return false;
+        }
+        remove(it->second);
+        return true;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return timers_.size();
+    }
+
+private:
+    bool on_timer_thread() const
+    {
+        return std::this_thread::get_id() == thread_.get_id();
+    }
+
+    uint64_t current_tick() const
+    {
+        return (Clock::now() - origin_) / resolution_;
+    }
+
+    TimerId add(std::unique_lock<std::mutex> &, std::chrono::milliseconds delay,
+                std::function<void()> func, TimerGroup * group);
+
+    void remove(Timer * timer)
+    {
+        timers_.erase(timer->id);
+        static_cast<SlotLink *>(timer)->unlink();
+        static_cast<GroupLink *>(timer)->unlink();
+        delete timer;
+    }
+
+    void place(Timer * timer)
+    {
+        uint64_t delta = timer->expires - now_;
+        unsigned level = 0;
+        while( level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))) ){
+            ++level;
+        }
+        size_t slot = (timer->expires >> (SLOT_BITS * level)) & (SLOTS - 1);
+        wheels_[level][slot].push_back(static_cast<SlotLink *>(timer));
+    }
+
+    // Moves the timers of the current slot of `level` to the lower levels
+    bool cascade(unsigned level)
+    {
+        size_t slot = (now_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+        SlotLink & head = wheels_[level][slot];
+        while( ! head.empty() ){
+            Timer * timer = from_slot(head.next);
+            static_cast<SlotLink *>(timer)->unlink();
+            place(timer);
+        }
+        return slot == 0;
+    }
+
+    // Processes tick now_, expired timers go to expired_
+    void advance()
+    {
+        if( (now_ & (SLOTS - 1)) == 0 ){
+            for( unsigned level = 1; level < LEVELS && cascade(level); ++level );
+        }
+        SlotLink & head = wheels_[0][now_ & (SLOTS - 1)];
+        while( ! head.empty() ){
+            Link * link = head.next;
+            link->unlink();
+            expired_.push_back(link);
+        }
+        ++now_;
+    }
+
+    // First tick worth waking up for: a non-empty slot of the lowest wheel, or its wrap-around
+    uint64_t next_wake_tick() const
+    {
+        uint64_t end = (now_ | (SLOTS - 1)) + 1;
+        for( uint64_t tick = now_; tick < end; ++tick ){
+            if( ! wheels_[0][tick & (SLOTS - 1)].empty() ) return tick;
+        }
+        return end;
+    }
+
+    void fire_expired(std::unique_lock<std::mutex> & lock);
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while( ! stopping_ ){
+            uint64_t tick = current_tick();
+            while( now_ <= tick && ! timers_.empty() ){
+                advance();
+                fire_expired(lock);
+                if( stopping_ ) return;
+            }
+            if( timers_.empty() ){
+                wake_tick_ = UINT64_MAX;
+                wake_cv_.wait(lock);
+                continue;
+            }
+            wake_tick_ = next_wake_tick();
+            wake_cv_.wait_until(lock, origin_ + resolution_ * static_cast<int64_t>(wake_tick_));
+        }
+    }
+};
+
+
+/*
+Timers of one owner, e.g. a pipeline. close() cancels all of them, waits for a
+running callback of the group and makes schedule() a no-op until open(), so the
+owner can release what the callbacks point to.
+*/
+
+class TimerGroup
+{
+    friend class TimerWheel;
+
+    TimerWheel & wheel_;
+    TimerWheel::GroupLink timers_;  // guarded by the wheel mutex
+    bool open_ {true};
+
+public:
+    explicit TimerGroup(TimerWheel & wheel = TimerWheel::get_instance()): wheel_(wheel) {}
+
+    TimerGroup(TimerGroup const &) = delete;
+    TimerGroup & operator=(TimerGroup const &) = delete;
+
+    ~TimerGroup()
+    {
+        close();
+    }
+
+    // Returns INVALID_TIMER if the group is closed
+    TimerWheel::TimerId schedule(std::chrono::milliseconds delay, std::function<void()> func)
+    {
+        std::unique_lock<std::mutex> lock(wheel_.mtx_);
+        if( ! open_ ) return TimerWheel::INVALID_TIMER;
+        return wheel_.add(lock, delay, std::move(func), this);
+    }
+
+    bool cancel(TimerWheel::TimerId id)
+    {
+        return wheel_.cancel(id);
+    }
+
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(wheel_.mtx_);
+        open_ = true;
+    }
+
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(wheel_.mtx_);
+        open_ = false;
+        while( ! timers_.empty() ){
+            wheel_.remove(static_cast<TimerWheel::Timer *>(
+                static_cast<TimerWheel::GroupLink *>(timers_.next)));
+        }
+        if( ! wheel_.on_timer_thread() ){
+            wheel_.done_cv_.wait(lock, [this]{ return wheel_.running_group_ != this; });
+        }
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(wheel_.mtx_);
+        size_t n = 0;
+        for( auto link = timers_.next; link != & timers_; link = link->next ) ++n;
+        return n;
+    }
+};
+
+
+inline TimerWheel::TimerId TimerWheel::add(std::unique_lock<std::mutex> &, std::chrono::milliseconds delay,
+                                           std::function<void()> func, TimerGroup * group)
+{
+    uint64_t tick = current_tick();
+    // Nothing pending, skip the idle ticks instead of walking through them
+    if( timers_.empty() && now_ < tick ) now_ = tick;
+    // The current tick has partly passed, one more keeps the delay a lower bound
+    uint64_t ticks = std::max<int64_t>(delay / resolution_, 0) + 1;
+    uint64_t expires = std::max(tick + ticks, now_);
+    if( expires - now_ > MAX_TICKS ) expires = now_ + MAX_TICKS;
+
+    auto timer = new Timer();
+    timer->id = next_id_++;
+    timer->expires = expires;
+    timer->group = group;
+    timer->func = std::move(func);
+    timers_.emplace(timer->id, timer);
+    if( group ) group->timers_.push_back(static_cast<GroupLink *>(timer));
+    place(timer);
+
+    if( expires < wake_tick_ ){
+        wake_tick_ = expires;
+        wake_cv_.notify_one();
+    }
+    return timer->id;
+}
+
+
+inline void TimerWheel::fire_expired(std::unique_lock<std::mutex> & lock)
+{
+    while( ! expired_.empty() ){
+        Timer * timer = from_slot(expired_.next);
+        auto func = std::move(timer->func);
+        running_id_ = timer->id;
+        running_group_ = timer->group;
+        remove(timer);
+
+        lock.unlock();
+        try{
+            func();
+        }catch(std::exception const & e){
+            std::cerr << "Unhandled exception in timer: " << e.what() << std::endl;
+        }
+        func = nullptr;
+        lock.lock();
+
+        running_id_ = INVALID_TIMER;
+        running_group_ = nullptr;
+        done_cv_.notify_all();
+    }
+}
+
+
+#endif  // __M2E_BRIDGE_TIMER_WHEEL_H__
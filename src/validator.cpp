@@ -26,6 +26,7 @@ IN THE SOFTWARE.
 #include <stdexcept>
 
 #include "validator.h"
+#include "pipeline.h"
 #include "connectors/all.h"
 
 
@@ -123,6 +124,26 @@ pair<bool, string> validate_pipeline(json const & config){
     if(! config.contains("connector_in")) return {false, "Missing connector_in"};
     if(! config.contains("connector_out")) return {false, "Missing connector_out"};
 
+    // Validate queue limits, batching and goto targets
+    try{
+        QueueConfig::from_json(config.value("queue", json::object()));
+        BatchConfig::from_json(config.value("batch", json::object()));
+        RoutingGraph::from_json(config.value("filtras", json::array()));
+    }catch(configuration_error const & e){
+        return {false, e.what()};
+    }
+
+    // Validate workers
+    if(config.contains("workers")){
+        json const & workers = config["workers"];
+        if(! workers.is_number_unsigned()
+                || workers.get<unsigned>() == 0
+                || workers.get<unsigned>() > Pipeline::MAX_WORKERS){
+            return {false, "Workers must be a positive integer not greater than "
+                + std::to_string(Pipeline::MAX_WORKERS)};
+        }
+    }
+
     // Validate connectors
     auto res = validate_connector(ConnectorMode::IN, config["connector_in"]);
     if(! res.first) return res;
@@ -94,7 +94,7 @@ public:
             std::streambuf* original_cerr = std::cerr.rdbuf(error_stream.rdbuf());
 
             REQUIRE(msg_w);
-            REQUIRE(msg_w.msg().get_raw() == raw_data);
+            REQUIRE(msg_w.view().get_raw() == raw_data);
 
             REQUIRE_NOTHROW(email_connector.do_send(msg_w));
 
@@ -153,7 +153,7 @@ public:
             std::streambuf* original_cerr = std::cerr.rdbuf(error_stream.rdbuf());
 
             REQUIRE(msg_w);
-            REQUIRE(msg_w.msg().get_raw() == raw_data);
+            REQUIRE(msg_w.view().get_raw() == raw_data);
 
             REQUIRE_NOTHROW(email_connector.do_send(msg_w));
 
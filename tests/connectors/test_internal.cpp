@@ -0,0 +1,75 @@
+#ifndef TEST_INTERNAL_CONNECTOR_H
+#define TEST_INTERNAL_CONNECTOR_H
+
+#include <catch2/catch_all.hpp>
+#include <nlohmann/json.hpp>
+
+#include "../src/connectors/internal_connector.h"
+
+
+TEST_CASE("InternalConnector - batch send and receive", "[internal_connector]"){
+    json config = {
+        {"type", "queue"},
+        {"name", "test_internal_batch"}
+    };
+
+    InternalConnector connector_in("test_pipeline_in", ConnectorMode::IN, config);
+    InternalConnector connector_out("test_pipeline_out", ConnectorMode::OUT, config);
+    connector_in.connect();
+    connector_out.connect();
+
+    std::vector<MessageWrapper> batch;
+    for(int i = 0; i < 5; ++i){
+        MessageWrapper msg_w(std::make_shared<Message>(std::to_string(i), MessageFormat::Type::RAW));
+        msg_w.set_message(Message(std::to_string(i), MessageFormat::Type::RAW));
+        batch.push_back(msg_w);
+    }
+    connector_out.send_batch(batch);
+    REQUIRE(connector_out.get_statistics().count_out == 5);
+
+    auto received = connector_in.receive_batch(3, std::chrono::milliseconds(0));
+    REQUIRE(received.size() == 3);
+    REQUIRE(received[0]->get_raw() == "0");
+    REQUIRE(received[2]->get_raw() == "2");
+
+    received = connector_in.receive_batch(10, std::chrono::milliseconds(20));
+    REQUIRE(received.size() == 2);
+    REQUIRE(received[1]->get_raw() == "4");
+    REQUIRE(connector_in.get_statistics().count_in == 5);
+
+    connector_in.disconnect();
+}
+
+
+TEST_CASE("InternalConnector - fan-out shares messages", "[internal_connector]"){
+    json config = {
+        {"type", "queue"},
+        {"name", "test_internal_fanout"}
+    };
+
+    InternalConnector connector_in_1("test_pipeline_in_1", ConnectorMode::IN, config);
+    InternalConnector connector_in_2("test_pipeline_in_2", ConnectorMode::IN, config);
+    InternalConnector connector_out("test_pipeline_out", ConnectorMode::OUT, config);
+    connector_in_1.connect();
+    connector_in_2.connect();
+
+    auto msg_ptr = std::make_shared<Message>(string("payload"), MessageFormat::Type::RAW);
+    MessageWrapper msg_w(msg_ptr);
+    connector_out.send(msg_w);
+
+    auto received_1 = connector_in_1.receive();
+    auto received_2 = connector_in_2.receive();
+    REQUIRE(received_1 == msg_ptr);
+    REQUIRE(received_2 == msg_ptr);
+
+    // A subscriber modifying the message gets its own copy
+    MessageWrapper msg_w_1(received_1);
+    msg_w_1.mut().set_raw("changed");
+    REQUIRE(msg_w_1.view().get_raw() == "changed");
+    REQUIRE(received_2->get_raw() == "payload");
+
+    connector_in_1.disconnect();
+    connector_in_2.disconnect();
+}
+
+#endif
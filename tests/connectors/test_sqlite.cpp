@@ -0,0 +1,97 @@
+#ifndef TEST_SQLITE_CONNECTOR_H
+#define TEST_SQLITE_CONNECTOR_H
+
+#ifdef WITH_IMAGE_HANDLERS
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <opencv2/opencv.hpp>
+#include <sqlite3.h>
+
+#include "../src/connectors/sqlite_connector.h"
+
+
+#define SQLITE_TEST_DB_PATH TEST_CONFIG_DIR "/db/sqlite_connector.sqlite"
+
+
+namespace TestSQLiteConnector {
+    inline void create_table(){
+        std::remove(SQLITE_TEST_DB_PATH);
+        sqlite3 * db;
+        REQUIRE(sqlite3_open(SQLITE_TEST_DB_PATH, & db) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(db, "CREATE TABLE images(id TEXT, small BLOB, same BLOB)",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(db);
+    }
+
+    inline std::vector<std::vector<std::string>> select_rows(){
+        std::vector<std::vector<std::string>> rows;
+        sqlite3 * db;
+        sqlite3_stmt * stmt;
+        REQUIRE(sqlite3_open(SQLITE_TEST_DB_PATH, & db) == SQLITE_OK);
+        REQUIRE(sqlite3_prepare_v2(db, "SELECT id, small, same FROM images ORDER BY rowid",
+                                   -1, & stmt, nullptr) == SQLITE_OK);
+        while(sqlite3_step(stmt) == SQLITE_ROW){
+            std::vector<std::string> row;
+            for(int i = 0; i < 3; ++i){
+                auto data = reinterpret_cast<char const *>(sqlite3_column_blob(stmt, i));
+                row.emplace_back(data, sqlite3_column_bytes(stmt, i));
+            }
+            rows.push_back(std::move(row));
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return rows;
+    }
+
+    inline cv::Size decoded_size(std::string const & image){
+        cv::Mat input(1, static_cast<int>(image.size()), CV_8UC1, const_cast<char *>(image.data()));
+        cv::Mat decoded = cv::imdecode(input, cv::IMREAD_COLOR);
+        REQUIRE_FALSE(decoded.empty());
+        return decoded.size();
+    }
+}
+
+
+TEST_CASE("SQLiteConnector - memoized modifier results through the batch path", "[sqlite_connector]"){
+    using namespace TestSQLiteConnector;
+    create_table();
+
+    // The second value hits the memo, both are bound as views into the engine
+    json config = {
+        {"type", "sqlite"},
+        {"db_path", SQLITE_TEST_DB_PATH},
+        {"table", "images"},
+        {"columns", {"id", "small", "same"}},
+        {"values", {"{{MSG.TOPIC}}", "{{EXTRA.image|resize,320,100}}", "{{EXTRA.image|resize,320,100}}"}}
+    };
+    SQLiteConnector connector("test", ConnectorMode::OUT, config);
+    connector.connect();
+
+    cv::Mat image(480, 640, CV_8UC3, cv::Scalar(40, 120, 200));
+    std::vector<uchar> jpeg;
+    REQUIRE(cv::imencode(".jpeg", image, jpeg));
+
+    std::vector<MessageWrapper> batch;
+    for(std::string topic : {"camera/1", "camera/2", "camera/3"}){
+        batch.emplace_back(std::make_shared<Message>(std::string("{}"), MessageFormat::Type::JSON, topic));
+        batch.back().get_extra().add_extra("image", std::vector<unsigned char>(jpeg.begin(), jpeg.end()));
+    }
+    connector.send_batch(batch);
+
+    auto rows = select_rows();
+    REQUIRE(rows.size() == 3);
+    for(size_t i = 0; i < rows.size(); ++i){
+        REQUIRE(rows[i][0] == "camera/" + std::to_string(i + 1));
+        REQUIRE(decoded_size(rows[i][1]) == cv::Size(320, 100));
+        REQUIRE(rows[i][2] == rows[i][1]);
+    }
+    std::remove(SQLITE_TEST_DB_PATH);
+}
+
+#endif  // WITH_IMAGE_HANDLERS
+
+#endif  // TEST_SQLITE_CONNECTOR_H
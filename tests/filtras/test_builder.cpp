@@ -42,7 +42,7 @@ TEST_CASE("BuilderFT", "[builder_filtra]"){
         BuilderFT builder_ft(mock_pi, filtras);
 
         builder_ft.process_message(msg_w_j);
-        REQUIRE(msg_w_j.msg().get_json() == payload);
+        REQUIRE(msg_w_j.view().get_json() == payload);
         REQUIRE(msg_w_j.is_passed());
     }
 
@@ -52,9 +52,112 @@ TEST_CASE("BuilderFT", "[builder_filtra]"){
 
         BuilderFT builder_ft(mock_pi, filtras);
         builder_ft.process_message(msg_w_j);
-        REQUIRE(msg_w_j.msg().get_json() == payload);
+        REQUIRE(msg_w_j.view().get_json() == payload);
         REQUIRE(msg_w_j.is_passed());
     }
 }
 
+TEST_CASE("BuilderFT - substitutions", "[builder_filtra]"){
+    MockPipeline mock_pi;
+
+    json filtras = {
+        {"name", "reshape"},
+        {"type", "builder"},
+        {"payload", {
+            {"device", "{{MSG.TOPIC_LEVELS[1]}}"},
+            {"label", "t={{MSG.PAYLOAD.temp}} in {{MSG.TOPIC}}"},
+            {"values", {"{{MSG.PAYLOAD.values[1]}}", "const"}},
+            {"temp", "{{MSG.PAYLOAD.temp}}"}
+        }}
+    };
+
+    BuilderFT builder_ft(mock_pi, filtras);
+
+    for(int i = 0; i < 2; ++i){
+        MessageWrapper msg_w(make_shared<Message>(
+            string(R"({"temp": "21", "values": [1, 2]})"), MessageFormat::Type::JSON, "site/dev1/data"));
+        builder_ft.process_message(msg_w);
+
+        json expected = {
+            {"device", "dev1"},
+            {"label", "t=21 in site/dev1/data"},
+            {"values", {"2", "const"}},
+            {"temp", "21"}
+        };
+        REQUIRE(msg_w.view().get_json() == expected);
+    }
+
+    // CBOR payloads are read in place, integers keep their type
+    MessageWrapper cbor_w(make_shared<Message>(
+        json{{"temp", "21"}, {"values", {1, 2}}}, MessageFormat::Type::CBOR, "site/dev1/data"));
+    builder_ft.process_message(cbor_w);
+    REQUIRE(cbor_w.view().get_json()["values"] == json{2, "const"});
+    REQUIRE(cbor_w.view().get_json()["label"] == "t=21 in site/dev1/data");
+
+    json broken = filtras;
+    broken["payload"]["label"] = "{{MSG..TOPIC}}";
+    REQUIRE_THROWS_AS(BuilderFT(mock_pi, broken), configuration_error);
+    broken["payload"]["label"] = "{{MSGS.TOPIC}}";
+    REQUIRE_THROWS_AS(BuilderFT(mock_pi, broken), configuration_error);
+}
+
+
+
+TEST_CASE("BuilderFT - encoders", "[builder_filtra]"){
+    MockPipeline mock_pi;
+
+    json filtras = {
+        {"type", "builder"},
+        {"payload", {
+            {"id", "{{MSG.PAYLOAD.id}}"},
+            {"note", "{{MSG.PAYLOAD.note}}!"},
+            {"flag", "{{MSG.PAYLOAD.flag}}"},
+            {"image", "{{EXTRA.img}}"},
+            {"fixed", {1, -300, 2.5, nullptr, "text"}}
+        }},
+        {"extra", {{"source", "{{MSG.TOPIC}}"}}}
+    };
+    json input = {{"id", -70000}, {"note", "say \"hi\"\n\x01"}, {"flag", true}};
+    json expected = {
+        {"id", -70000},
+        {"note", "say \"hi\"\n\x01!"},
+        {"flag", true},
+        {"fixed", {1, -300, 2.5, nullptr, "text"}}
+    };
+
+    std::vector<unsigned char> image {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00};
+
+    SECTION("json"){
+        BuilderFT builder_ft(mock_pi, filtras);
+        MessageWrapper msg_w(make_shared<Message>(input, MessageFormat::Type::CBOR, "site/dev1"));
+        msg_w.get_extra().add_extra("img", image);
+        expected["image"] = "/9j/4AAQSkZJRgA=";
+        builder_ft.process_message(msg_w);
+
+        REQUIRE(msg_w.view().get_format() == MessageFormat::Type::JSON);
+        REQUIRE(msg_w.view().get_raw() == expected.dump());
+        REQUIRE(msg_w.view().get_topic() == "site/dev1");
+        auto & extra = msg_w.get_extra();
+        extra.set_key("source");
+        REQUIRE(string(reinterpret_cast<char const *>(extra.get_extra()), extra.get_extra_size()) == "\"site/dev1\"");
+    }
+
+    SECTION("cbor"){
+        filtras["encoder"] = "cbor";
+        BuilderFT builder_ft(mock_pi, filtras);
+        MessageWrapper msg_w(make_shared<Message>(input, MessageFormat::Type::CBOR, "site/dev1"));
+        msg_w.get_extra().add_extra("img", image);
+        expected["image"] = json::binary(image);
+        builder_ft.process_message(msg_w);
+
+        REQUIRE(msg_w.view().get_format() == MessageFormat::Type::CBOR);
+        auto cbor = json::to_cbor(expected);
+        REQUIRE(msg_w.view().get_raw() == string(cbor.begin(), cbor.end()));
+        REQUIRE(msg_w.view().get_json() == expected);
+    }
+
+    filtras["encoder"] = "xml";
+    REQUIRE_THROWS_AS(BuilderFT(mock_pi, filtras), configuration_error);
+}
+
 #endif
\ No newline at end of file
@@ -51,8 +51,8 @@ TEST_CASE("ComparatorFT", "[comparator_filtra]"){
     json initial_msg_f = {{val_key, random_float}};
     MessageWrapper msg_wf(std::make_shared<Message>(initial_msg_f, MessageFormat::Type::JSON, "/topc/test"));
 
-    json const & msg_payload_i = msg_wi.msg().get_json();
-    json const & msg_payload_f = msg_wf.msg().get_json();
+    json const & msg_payload_i = msg_wi.view().get_json();
+    json const & msg_payload_f = msg_wf.view().get_json();
 
     json const & msg_value_i = msg_payload_i.at(val_key);
     json const & msg_value_f = msg_payload_f.at(val_key);
@@ -0,0 +1,149 @@
+#ifndef TEST_CONVERTER_LUA_H
+#define TEST_CONVERTER_LUA_H
+
+#ifdef WITH_LUA
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <sqlite3.h>
+
+#include "../src/filtras/converter_lua.h"
+#include "mock_pipeline.h"
+
+
+#define CONFIG_PATH TEST_CONFIG_DIR "/m2e-bridge.json"
+
+
+namespace TestLuaConverter {
+    inline void set_converter(std::string const & id, std::string const & code){
+        gc.load(CONFIG_PATH);
+        sqlite3 * db;
+        REQUIRE(sqlite3_open(gc.get_converters_db_path().c_str(), & db) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(db,
+            "CREATE TABLE IF NOT EXISTS converters (id TEXT PRIMARY KEY, code TEXT, description TEXT);",
+            nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_stmt * stmt;
+        sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO converters (id, code, description) VALUES (?, ?, '');",
+            -1, & stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, code.c_str(), -1, SQLITE_TRANSIENT);
+        REQUIRE(sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+    }
+
+    inline MessageWrapper make_message(std::string const & payload){
+        return MessageWrapper(std::make_shared<Message>(payload, MessageFormat::Type::JSON, "t/1"));
+    }
+
+    inline json config(std::string const & id, std::string const & payload){
+        return {{"type", "lua_converter"}, {"converter_id", id}, {"payload", payload}};
+    }
+}
+
+
+TEST_CASE("LuaConverterFT - payload modes", "[lua_converter]"){
+    using namespace TestLuaConverter;
+    MockPipeline mock_pi;
+
+    set_converter("lua_string", "function convert(p) return p:upper() end");
+    LuaConverterFT string_ft(mock_pi, config("lua_string", "string"));
+    string_ft.start();
+    auto msg_w = make_message(R"({"unit": "c"})");
+    string_ft.process(msg_w);
+    REQUIRE(msg_w.is_passed());
+    REQUIRE(msg_w.view().get_raw() == R"({"UNIT": "C"})");
+
+    set_converter("lua_view", "function convert(v) return v:sub(2, 7) .. #v end");
+    LuaConverterFT view_ft(mock_pi, config("lua_view", "view"));
+    view_ft.start();
+    msg_w = make_message(R"({"unit": "c"})");
+    view_ft.process(msg_w);
+    REQUIRE(msg_w.view().get_raw() == R"("unit"13)");
+
+    set_converter("lua_table", "function convert(t) return {temp = t.temp + 1, unit = t.unit} end");
+    LuaConverterFT table_ft(mock_pi, config("lua_table", "table"));
+    table_ft.start();
+    msg_w = make_message(R"({"temp": 20, "unit": "c"})");
+    table_ft.process(msg_w);
+    REQUIRE(json::parse(msg_w.view().get_raw()) == json({{"temp", 21}, {"unit", "c"}}));
+}
+
+
+TEST_CASE("LuaConverterFT - state is kept while the code is unchanged", "[lua_converter]"){
+    using namespace TestLuaConverter;
+    MockPipeline mock_pi;
+
+    set_converter("lua_count", "n = 0 function convert(p) n = n + 1 return tostring(n) end");
+    LuaConverterFT ft(mock_pi, config("lua_count", "string"));
+    ft.start();
+    auto msg_w = make_message("{}");
+    ft.process(msg_w);
+    ft.start();
+    msg_w = make_message("{}");
+    ft.process(msg_w);
+    REQUIRE(msg_w.view().get_raw() == "2");
+
+    set_converter("lua_count", "n = 10 function convert(p) n = n + 1 return tostring(n) end");
+    ft.start();
+    msg_w = make_message("{}");
+    ft.process(msg_w);
+    REQUIRE(msg_w.view().get_raw() == "11");
+}
+
+
+TEST_CASE("LuaConverterFT - errors", "[lua_converter]"){
+    using namespace TestLuaConverter;
+    MockPipeline mock_pi;
+
+    set_converter("lua_syntax", "function convert(p) return p:upper( end");
+    LuaConverterFT syntax_ft(mock_pi, config("lua_syntax", "string"));
+    REQUIRE_THROWS_AS(syntax_ft.start(), std::runtime_error);
+
+    set_converter("lua_failing", "function convert(p) error('bad payload') end");
+    LuaConverterFT failing_ft(mock_pi, config("lua_failing", "string"));
+    failing_ft.start();
+    auto msg_w = make_message("{}");
+    REQUIRE_THROWS_WITH(failing_ft.process(msg_w), Catch::Matchers::Contains("bad payload"));
+
+}
+
+TEST_CASE("LuaConverterFT - a failing batch leaves the messages untouched", "[lua_converter]"){
+    using namespace TestLuaConverter;
+    MockPipeline mock_pi;
+
+    set_converter("lua_batch", R"(
+        function convert_batch(ps)
+            local out = {}
+            for i = 1, #ps do
+                if ps[i] == "bad" then out[i] = false else out[i] = ps[i]:upper() end
+            end
+            return out
+        end
+    )");
+    LuaConverterFT ft(mock_pi, config("lua_batch", "string"));
+    ft.start();
+    REQUIRE(ft.takes_batches());
+
+    std::vector<MessageWrapper> batch;
+    for(auto p : {"a", "bad", "c"}) batch.push_back(make_message(p));
+    REQUIRE_THROWS_AS(ft.process(std::span<MessageWrapper>(batch)), std::runtime_error);
+    REQUIRE(batch[0].view().get_raw() == "a");
+    REQUIRE(batch[2].view().get_raw() == "c");
+
+    // What the pipeline does next, only the bad message fails
+    ft.process(batch[0]);
+    REQUIRE_THROWS_AS(ft.process(batch[1]), std::runtime_error);
+    ft.process(batch[2]);
+    REQUIRE(batch[0].view().get_raw() == "A");
+    REQUIRE(batch[2].view().get_raw() == "C");
+    REQUIRE(batch[2].is_passed());
+}
+
+
+#endif  // WITH_LUA
+
+#endif
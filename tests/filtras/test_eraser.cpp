@@ -30,7 +30,7 @@ TEST_CASE("EraserFT", "[eraser_filtra]"){
     eraser_ft.process_message(msg_w);
 
     for(int i = 0; i < v_keys.size(); i++){
-        REQUIRE_FALSE(msg_w.msg().get_json().contains(v_keys[i]));
+        REQUIRE_FALSE(msg_w.view().get_json().contains(v_keys[i]));
     }
 }
 
@@ -41,7 +41,7 @@ TEST_CASE("FinderFT - String", "[finder_filtra]")
         FinderFT finder_ft(mock_pi, filtras);
 
         finder_ft.process_message(msg_w_1);
-        REQUIRE(msg_w_1.msg().get_raw().find(string) != std::string::npos);
+        REQUIRE(msg_w_1.view().get_raw().find(string) != std::string::npos);
         REQUIRE(msg_w_1.is_passed());
 
         finder_ft.process_message(msg_w_2);
@@ -67,7 +67,7 @@ TEST_CASE("FinderFT - String", "[finder_filtra]")
         REQUIRE_FALSE(msg_w_2.is_passed());
 
         finder_ft.process_message(msg_w_3);
-        REQUIRE(string.find(msg_w_3.msg().get_raw()) != std::string::npos);
+        REQUIRE(string.find(msg_w_3.view().get_raw()) != std::string::npos);
         REQUIRE(msg_w_3.is_passed());
     }
 
@@ -87,7 +87,7 @@ TEST_CASE("FinderFT - String", "[finder_filtra]")
         FinderFT finder_ft(mock_pi, filtras);
 
         finder_ft.process_message(msg_w_1);
-        REQUIRE(msg_w_1.msg().get_raw() == string);
+        REQUIRE(msg_w_1.view().get_raw() == string);
         REQUIRE(msg_w_1.is_passed());
 
         finder_ft.process_message(msg_w_3);
@@ -99,7 +99,7 @@ TEST_CASE("FinderFT - String", "[finder_filtra]")
         FinderFT finder_ft(mock_pi, filtras);
 
         finder_ft.process_message(msg_w_1);
-        REQUIRE(msg_w_1.msg().get_raw() == string);
+        REQUIRE(msg_w_1.view().get_raw() == string);
         REQUIRE_FALSE(msg_w_1.is_passed());
 
         finder_ft.process_message(msg_w_3);
@@ -302,4 +302,64 @@ TEST_CASE("FinderFT - Value Key", "[finder_filtra]")
     }
 }
 
+
+TEST_CASE("FinderFT - Patterns", "[finder_filtra]")
+{
+    MockPipeline mock_pi;
+
+    json filtras = {
+        {"type", "finder"},
+        {"patterns", {"error", "fatal", "timeout"}},
+        {"case_insensitive", true}
+    };
+
+    FinderFT finder_ft(mock_pi, filtras);
+
+    MessageWrapper msg_w_1(std::make_shared<Message>(std::string("db: connection TIMEOUT, then Error"), MessageFormat::Type::RAW));
+    finder_ft.process(msg_w_1);
+    REQUIRE(msg_w_1.is_passed());
+    REQUIRE(msg_w_1.get_metadata().at("matched_pattern") == "timeout");
+
+    MessageWrapper msg_w_2(std::make_shared<Message>(std::string("all good"), MessageFormat::Type::RAW));
+    finder_ft.process(msg_w_2);
+    REQUIRE_FALSE(msg_w_2.is_passed());
+
+    filtras["case_insensitive"] = false;
+    filtras["value_key"] = "log";
+    filtras["msg_format"] = "json";
+    FinderFT value_ft(mock_pi, filtras);
+
+    MessageWrapper msg_w_3(std::make_shared<Message>(std::string(R"({"log": "Fatal: disk", "x": "error"})"), MessageFormat::Type::JSON));
+    value_ft.process(msg_w_3);
+    REQUIRE_FALSE(msg_w_3.is_passed());
+
+    filtras["patterns"] = json::array({""});
+    REQUIRE_THROWS_AS(FinderFT(mock_pi, filtras), configuration_error);
+}
+
+
+TEST_CASE("FinderFT - Regex", "[finder_filtra]")
+{
+    MockPipeline mock_pi;
+
+    json filtras = {
+        {"type", "finder"},
+        {"operator", "regex"},
+        {"text", "^temp/[0-9]+: (ERROR|FATAL)"}
+    };
+
+    FinderFT finder_ft(mock_pi, filtras);
+
+    MessageWrapper msg_w_1(std::make_shared<Message>(std::string("temp/12: FATAL overheat"), MessageFormat::Type::RAW));
+    finder_ft.process(msg_w_1);
+    REQUIRE(msg_w_1.is_passed());
+
+    MessageWrapper msg_w_2(std::make_shared<Message>(std::string("note temp/12: ERROR"), MessageFormat::Type::RAW));
+    finder_ft.process(msg_w_2);
+    REQUIRE_FALSE(msg_w_2.is_passed());
+
+    filtras["text"] = "(unclosed";
+    REQUIRE_THROWS_AS(FinderFT(mock_pi, filtras), configuration_error);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#ifndef TEST_IMAGE_FILTRA_H
+#define TEST_IMAGE_FILTRA_H
+
+#ifdef WITH_IMAGE_HANDLERS
+
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "../src/filtras/image.h"
+#include "mock_pipeline.h"
+
+
+namespace TestImageFiltra {
+    // A 640x480 JPEG
+    inline std::string make_jpeg(){
+        cv::Mat image(480, 640, CV_8UC3, cv::Scalar(40, 120, 200));
+        std::vector<uchar> encoded;
+        REQUIRE(cv::imencode(".jpeg", image, encoded));
+        return std::string(encoded.begin(), encoded.end());
+    }
+
+    inline MessageWrapper make_message(std::string const & image){
+        return MessageWrapper(std::make_shared<Message>(image, MessageFormat::Type::RAW, "camera/1"));
+    }
+
+    inline std::string extra_bytes(MessageWrapper & msg_w, std::string const & key){
+        auto & extra = msg_w.get_extra();
+        extra.set_key(key);
+        return std::string(reinterpret_cast<char const *>(extra.get_extra()), extra.get_extra_size());
+    }
+
+    inline cv::Size decoded_size(std::string const & image){
+        cv::Mat input(1, static_cast<int>(image.size()), CV_8UC1, const_cast<char *>(image.data()));
+        cv::Mat decoded = cv::imdecode(input, cv::IMREAD_COLOR);
+        REQUIRE_FALSE(decoded.empty());
+        return decoded.size();
+    }
+
+    inline json renditions_config(bool parallel){
+        return {
+            {"type", "image"},
+            {"operation", "renditions"},
+            {"parallel", parallel},
+            {"renditions", {
+                {{"extra", "thumbnail"}, {"width", 160}, {"format", "webp"}, {"quality", 75}},
+                {{"extra", "preview"}, {"width", 320}, {"height", 200}},
+                {{"extra", "original"}, {"format", "png"}}
+            }}
+        };
+    }
+
+    inline void check_renditions(MessageWrapper & msg_w){
+        REQUIRE(msg_w.is_passed());
+
+        std::string thumbnail = extra_bytes(msg_w, "thumbnail");
+        REQUIRE(thumbnail.substr(0, 4) == "RIFF");
+        REQUIRE(thumbnail.substr(8, 4) == "WEBP");
+        REQUIRE(decoded_size(thumbnail) == cv::Size(160, 120));
+
+        std::string preview = extra_bytes(msg_w, "preview");
+        REQUIRE(static_cast<unsigned char>(preview[0]) == 0xFF);
+        REQUIRE(static_cast<unsigned char>(preview[1]) == 0xD8);
+        REQUIRE(decoded_size(preview) == cv::Size(320, 200));
+
+        std::string original = extra_bytes(msg_w, "original");
+        REQUIRE(original.substr(1, 3) == "PNG");
+        REQUIRE(decoded_size(original) == cv::Size(640, 480));
+    }
+
+    // Never starts a task on its own, as if every executor thread was busy
+    class SaturatedRunner: public TaskRunner
+    {
+    public:
+        using TaskRunner::submit;
+        std::vector<ExecutorTask *> tasks;
+
+        void submit(ExecutorTask * task) override{
+            tasks.push_back(task);
+        }
+
+        void run_all(){
+            for(auto task : tasks) run_task(task);
+            tasks.clear();
+        }
+    };
+}
+
+
+TEST_CASE("ImageFT - renditions from one decode", "[image_filtra]"){
+    using namespace TestImageFiltra;
+    MockPipeline mock_pi;
+
+    ImageFT image_ft(mock_pi, renditions_config(false));
+    auto msg_w = make_message(make_jpeg());
+    image_ft.process(msg_w);
+
+    check_renditions(msg_w);
+}
+
+
+TEST_CASE("ImageFT - parallel renditions", "[image_filtra]"){
+    using namespace TestImageFiltra;
+    MockPipeline mock_pi;
+    Executor executor(4);
+    std::string image = make_jpeg();
+
+    ImageFT image_ft(mock_pi, renditions_config(true), executor);
+    for(int i = 0; i < 20; ++i){
+        auto msg_w = make_message(image);
+        image_ft.process(msg_w);
+        check_renditions(msg_w);
+    }
+}
+
+
+TEST_CASE("ImageFT - parallel renditions without free executor threads", "[image_filtra]"){
+    using namespace TestImageFiltra;
+    MockPipeline mock_pi;
+    SaturatedRunner runner;
+
+    ImageFT image_ft(mock_pi, renditions_config(true), runner);
+    auto msg_w = make_message(make_jpeg());
+    image_ft.process(msg_w);
+
+    // The caller encoded every rendition itself
+    REQUIRE(runner.tasks.size() == 2);
+    check_renditions(msg_w);
+
+    // The tasks run late, find their renditions taken and leave the message alone
+    runner.run_all();
+    check_renditions(msg_w);
+}
+
+
+TEST_CASE("ImageFT - renditions configuration", "[image_filtra]"){
+    MockPipeline mock_pi;
+    json config = {{"type", "image"}, {"operation", "renditions"}, {"renditions", json::array()}};
+    REQUIRE_THROWS_AS(ImageFT(mock_pi, config), configuration_error);
+
+    config["renditions"] = {{{"extra", "small"}, {"width", 100}, {"format", "gif"}}};
+    REQUIRE_THROWS_AS(ImageFT(mock_pi, config), configuration_error);
+
+    config["renditions"] = {{{"extra", "small"}, {"width", -1}}};
+    REQUIRE_THROWS_AS(ImageFT(mock_pi, config), configuration_error);
+}
+
+#endif  // WITH_IMAGE_HANDLERS
+
+#endif
@@ -25,7 +25,7 @@ TEST_CASE("LimiterFT", "[limiter_filtra]"){
         std::make_shared<Message>(initial_msg.dump(), MessageFormat::Type::JSON, "/topc/test")
     );
 
-    string const & msg_data = msg_w.msg().get_raw();
+    std::string_view msg_data = msg_w.view().get_raw();
 
     SECTION("Data size is smaller then size limit"){
         LimiterFT limiter_ft(mock_pi, filtras);
@@ -25,7 +25,7 @@ TEST_CASE("SplitterFT", "[splitter_filtra]"){
         std::make_shared<Message>(initial_msg, MessageFormat::Type::RAW, std::string("/topc/test"))
     );
 
-    string const & msg_data = msg_w.msg().get_raw();
+    std::string_view msg_data = msg_w.view().get_raw();
 
     SECTION("Smaller chunk_size"){
         SplitterFT splitter_ft(mock_pi, filtras);
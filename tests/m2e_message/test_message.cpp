@@ -0,0 +1,198 @@
+#ifndef TEST_MESSAGE_H
+#define TEST_MESSAGE_H
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/m2e_message/message_wrapper.h"
+
+
+TEST_CASE("MessageWrapper - copy on write", "[message]"){
+    auto orig = std::make_shared<Message>(string(R"({"a": 1, "b": 2})"), MessageFormat::Type::JSON, "t/1");
+    MessageWrapper msg_w(orig);
+
+    // Reading does not copy
+    REQUIRE(& msg_w.view() == orig.get());
+    REQUIRE(msg_w.view().get_json()["a"] == 1);
+    REQUIRE(msg_w.msg_ptr() == orig);
+
+    // The copy shares the payload until it is modified
+    Message & msg = msg_w.mut();
+    REQUIRE(& msg != orig.get());
+    REQUIRE(msg.get_raw() == orig->get_raw());
+
+    msg.get_json().erase("b");
+    REQUIRE(msg_w.view().get_raw() == R"({"a":1})");
+    REQUIRE(std::as_const(* orig).get_json().contains("b"));
+    REQUIRE(orig->get_raw() == R"({"a": 1, "b": 2})");
+
+    msg.set_raw("raw");
+    REQUIRE(msg_w.view().get_raw() == "raw");
+    REQUIRE(msg_w.view().get_topic() == "t/1");
+    REQUIRE(orig->get_raw() == R"({"a": 1, "b": 2})");
+
+    // A shared message is not modified anymore, the next modification copies it
+    auto shared = msg_w.msg_ptr();
+    REQUIRE(& msg_w.view() == shared.get());
+    msg_w.mut().set_raw("again");
+    REQUIRE(shared->get_raw() == "raw");
+}
+
+
+TEST_CASE("PayloadBuffer - inline and shared storage", "[message]"){
+    PayloadBuffer small(std::string_view("{\"t\": 21.5}"));
+    REQUIRE(small.is_inline());
+    REQUIRE(small.view() == "{\"t\": 21.5}");
+
+    std::string data(PayloadBuffer::INLINE_CAPACITY + 1, 'x');
+    char const * bytes = data.data();
+    PayloadBuffer large(std::move(data));
+    REQUIRE_FALSE(large.is_inline());
+    REQUIRE(large.data() == bytes);  // adopted, not copied
+    REQUIRE(large.uchars().size() == PayloadBuffer::INLINE_CAPACITY + 1);
+
+    // Copies of a message share a large payload
+    Message msg(PayloadBuffer(large), MessageFormat::Type::RAW, "t");
+    Message copy(msg);
+    REQUIRE(copy.get_payload().shares(msg.get_payload()));
+    REQUIRE(copy.get_payload_byte().data() == msg.get_payload_byte().data());
+
+    copy.set_raw("y");
+    REQUIRE(copy.get_raw() == "y");
+    REQUIRE(msg.get_raw().size() == PayloadBuffer::INLINE_CAPACITY + 1);
+}
+
+TEST_CASE("Message - topic levels", "[message]"){
+    Message msg(string("{}"), MessageFormat::Type::JSON, "/site//sensor/temp/");
+    REQUIRE(msg.get_topic_level(0) == "");
+    REQUIRE(msg.get_topic_level(1) == "site");
+    REQUIRE(msg.get_topic_level(2) == "");
+    REQUIRE(msg.get_topic_level(4) == "temp");
+    REQUIRE_FALSE(msg.find_topic_level(5));
+    REQUIRE(msg.get_topic_levels() == std::vector<std::string_view>{"", "site", "", "sensor", "temp"});
+
+    // Copies share the topic and its levels
+    Message copy(msg);
+    REQUIRE(copy.get_topic_ptr() == msg.get_topic_ptr());
+    REQUIRE(copy.get_topic_levels().data() == msg.get_topic_levels().data());
+
+    REQUIRE(Message().get_topic_levels().empty());
+    REQUIRE_FALSE(Message().find_topic_level(0));
+
+    TopicCache cache;
+    REQUIRE(cache.intern("a/b") == cache.intern(std::string("a/b")));
+    REQUIRE(cache.intern("a/b") != cache.intern("a/c"));
+    REQUIRE(cache.intern("") == nullptr);
+}
+
+
+TEST_CASE("JsonScanner - locate values", "[message]"){
+    using Status = JsonScanner::Status;
+    string doc = R"( {"a": {"x": [1, "]}\"", {"y": 2}]}, "kA": 3, "t": -1.5e3, "a": "last"} )";
+
+    REQUIRE(JsonScanner::find_member(doc, "a").value == R"("last")");
+    REQUIRE(JsonScanner::find_member(doc, "kA").value == "3");
+    REQUIRE(JsonScanner::find_member(doc, "t").value == "-1.5e3");
+    REQUIRE(JsonScanner::find_member(doc, "x").status == Status::MISSING);
+    REQUIRE(JsonScanner::find_member("[1]", "a").status == Status::INVALID);
+    REQUIRE(JsonScanner::find_member(R"({"a": [1, )", "a").status == Status::INVALID);
+
+    auto x = JsonScanner::find_member(R"({"x": [1, "]}\"", {"y": 2}]})", "x").value;
+    REQUIRE(JsonScanner::find_element(x, 1).value == R"("]}\"")");
+    REQUIRE(JsonScanner::find_element(x, 2).value == R"({"y": 2})");
+    REQUIRE(JsonScanner::find_element(x, 3).status == Status::MISSING);
+}
+
+
+TEST_CASE("Message - JSON members without decoding", "[message]"){
+    Message msg(string(R"({"temp": 21.5, "name": "s1"})"), MessageFormat::Type::JSON);
+
+    REQUIRE(msg.get_json_member("temp") == 21.5);
+    REQUIRE(msg.has_json_member("name"));
+    REQUIRE_FALSE(msg.get_json_member("hum"));
+    REQUIRE(msg.get_json_text());
+
+    // Once modified, members are read from the DOM
+    msg.get_json()["hum"] = 40;
+    REQUIRE_FALSE(msg.get_json_text());
+    REQUIRE(msg.get_json_member("hum") == 40);
+
+    Message broken(string("{\"temp\": "), MessageFormat::Type::JSON);
+    REQUIRE_THROWS_AS(broken.get_json_member("temp"), json::parse_error);
+
+    // Other formats are never scanned as JSON text
+    std::vector<uint8_t> cbor = json::to_cbor(json{{"temp", 21.5}});
+    Message binary(string(cbor.begin(), cbor.end()), MessageFormat::Type::CBOR);
+    REQUIRE_FALSE(binary.get_json_text());
+    REQUIRE(binary.get_json_member("temp") == 21.5);
+    REQUIRE_FALSE(binary.has_json_member("hum"));
+}
+
+
+TEST_CASE("CborValue - read in place", "[message]"){
+    json j = {{"temp", -21}, {"ratio", 0.5}, {"on", true}, {"name", "s1"},
+              {"blob", json::binary({1, 2, 3})}, {"list", {1, "two", {{"k", 3}}}}};
+    for(int i = 0; i < 20; ++i){
+        j["key" + std::to_string(i)] = i;
+    }
+    Message msg(j, MessageFormat::Type::CBOR);
+
+    CborValue root = msg.get_cbor();
+    REQUIRE(root.is_map());
+    REQUIRE(root.size() == j.size());
+    REQUIRE(root.find("temp")->as_int() == -21);
+    REQUIRE(root.find("ratio")->as_double() == 0.5);
+    REQUIRE(root.find("on")->as_bool());
+    REQUIRE(root.find("name")->text() == "s1");
+    REQUIRE(root.find("blob")->bytes().size() == 3);
+    REQUIRE(root.find("key17")->as_int() == 17);
+    REQUIRE_FALSE(root.find("missing"));
+
+    CborValue list = * root.find("list");
+    REQUIRE(list.at(1)->text() == "two");
+    REQUIRE(list.at(2)->find("k")->as_int() == 3);
+    REQUIRE_FALSE(list.at(3));
+
+    // Half float, a tag and an indefinite length map
+    std::vector<std::byte> raw;
+    for(int b : {0xBF, 0x61, int('h'), 0xF9, 0x3E, 0x00, 0x61, int('t'), 0xC1, 0x1A, 0, 0, 0, 5, 0xFF}){
+        raw.push_back(std::byte(b));
+    }
+    CborValue indefinite(raw);
+    REQUIRE(indefinite.size() == 2);
+    REQUIRE(indefinite.find("h")->as_double() == 1.5);
+    REQUIRE(indefinite.find("t")->as_int() == 5);
+
+    raw.pop_back();
+    REQUIRE_THROWS(CborValue(raw).validate());
+    REQUIRE_THROWS(Message(string("\x1A\x01"), MessageFormat::Type::CBOR).get_cbor());
+}
+
+
+TEST_CASE("Message - parsed and serialized once", "[message]"){
+    auto orig = std::make_shared<Message>(string(R"({"a": 1, "b": 2})"), MessageFormat::Type::JSON);
+    MessageWrapper msg_w(orig);
+
+    // Reading both forms invalidates neither
+    json const * dom = & msg_w.view().get_json();
+    char const * raw = msg_w.view().get_raw().data();
+    REQUIRE(& msg_w.view().get_json() == dom);
+    REQUIRE(msg_w.view().get_raw().data() == raw);
+
+    // A modification drops only the raw form, which is serialized once again
+    msg_w.mut().get_json().erase("b");
+    dom = & msg_w.view().get_json();
+    std::string_view serialized = msg_w.view().get_raw();
+    REQUIRE(serialized == R"({"a":1})");
+    REQUIRE(& msg_w.view().get_json() == dom);
+    REQUIRE(msg_w.view().get_raw().data() == serialized.data());
+
+    // CBOR payloads are decoded and serialized as CBOR
+    Message cbor(json{{"a", 1}}, MessageFormat::Type::CBOR);
+    cbor.set_raw(std::string(cbor.get_raw()));
+    cbor.get_json()["b"] = 2;
+    REQUIRE(cbor.get_format() == MessageFormat::Type::CBOR);
+    REQUIRE(json::from_cbor(cbor.get_raw()) == json{{"a", 1}, {"b", 2}});
+}
+
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef TEST_PIPELINE_H
+#define TEST_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/pipeline.h"
+#include "../src/internal_queue.h"
+
+
+namespace TestPipeline {
+    inline bool wait_until(std::function<bool()> pred,
+                           std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)){
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while(! pred()){
+            if(std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // Keeps every Executor thread busy, so the processing and sending tasks of
+    // pipelines wait and their queues fill up
+    class ExecutorBlocker{
+        std::atomic<unsigned> started_ {0};
+        std::atomic<unsigned> finished_ {0};
+        std::atomic<bool> released_ {false};
+        unsigned threads_;
+    public:
+        ExecutorBlocker(){
+            auto & executor = Executor::get_instance();
+            threads_ = executor.size();
+            for(unsigned ix = 0; ix < threads_; ++ix){
+                executor.submit([this]{
+                    ++started_;
+                    while(! released_) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    ++finished_;
+                });
+            }
+            REQUIRE(wait_until([this]{ return started_ == threads_; }));
+        }
+
+        ~ExecutorBlocker(){
+            release();
+            while(finished_ < threads_) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        void release(){
+            released_ = true;
+        }
+    };
+
+    inline json pipeline_config(std::string const & name, json const & queue){
+        return {
+            {"connector_in", {{"type", "queue"}, {"name", name + "_in"}}},
+            {"connector_out", {{"type", "queue"}, {"name", name + "_out"}}},
+            {"queue", queue}
+        };
+    }
+
+    inline void start(Pipeline & pipeline){
+        pipeline.start();
+        REQUIRE(wait_until([& pipeline]{ return pipeline.get_state() == PipelineState::RUNNING; }));
+        // The connector-in subscribes to its queue right after
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    inline void send(std::string const & name, int first, int last){
+        for(int i = first; i < last; ++i){
+            InternalQueue::get_queue(name + "_in").push(Message(std::to_string(i), MessageFormat::Type::RAW));
+        }
+    }
+
+    inline std::vector<std::string> receive(RQueue & queue, size_t count){
+        std::vector<std::string> received;
+        while(received.size() < count){
+            auto msg_ptr = queue.try_pop(std::chrono::milliseconds(1000));
+            if(! msg_ptr) break;
+            received.emplace_back((* msg_ptr)->get_raw());
+        }
+        // Nothing more is coming
+        REQUIRE_FALSE(queue.try_pop(std::chrono::milliseconds(50)));
+        return received;
+    }
+
+    inline std::vector<std::string> range(int first, int last){
+        std::vector<std::string> values;
+        for(int i = first; i < last; ++i) values.push_back(std::to_string(i));
+        return values;
+    }
+}
+
+
+TEST_CASE("QueueConfig - from json", "[pipeline]"){
+    auto qc = QueueConfig::from_json(json::object());
+    REQUIRE(qc.capacity == 1024);
+    REQUIRE(qc.capacity_bytes == 0);
+    REQUIRE(qc.overflow == OverflowPolicy::Type::BLOCK);
+    REQUIRE(qc.dlq.empty());
+
+    qc = QueueConfig::from_json({{"capacity", 8}, {"capacity_bytes", 4096}, {"overflow", "dlq"}, {"dlq", "dead"}});
+    REQUIRE(qc.capacity == 8);
+    REQUIRE(qc.capacity_bytes == 4096);
+    REQUIRE(qc.overflow == OverflowPolicy::Type::DLQ);
+    REQUIRE(qc.dlq == "dead");
+
+    REQUIRE(QueueConfig::from_json({{"overflow", "drop_oldest"}}).overflow == OverflowPolicy::Type::DROP_OLDEST);
+    REQUIRE(QueueConfig::from_json({{"overflow", "drop_newest"}}).overflow == OverflowPolicy::Type::DROP_NEWEST);
+
+    REQUIRE_THROWS_AS(QueueConfig::from_json(json::array()), configuration_error);
+    REQUIRE_THROWS_AS(QueueConfig::from_json({{"capacity", 0}}), configuration_error);
+    REQUIRE_THROWS_AS(QueueConfig::from_json({{"capacity", "many"}}), configuration_error);
+    REQUIRE_THROWS_AS(QueueConfig::from_json({{"overflow", "drop_all"}}), configuration_error);
+    REQUIRE_THROWS_AS(QueueConfig::from_json({{"overflow", "dlq"}}), configuration_error);
+}
+
+
+TEST_CASE("Pipeline - block overflow policy", "[pipeline]"){
+    using namespace TestPipeline;
+    Pipeline pipeline("test_block", pipeline_config("test_block", {{"capacity", 4}, {"overflow", "block"}}));
+    RQueue out = InternalQueue::get_queue("test_block_out").subscribe(0);
+    start(pipeline);
+
+    ExecutorBlocker blocker;
+    send("test_block", 0, 10);
+    // The receiving waits with the fifth message
+    REQUIRE(wait_until([& pipeline]{
+        auto stat = pipeline.get_statistics();
+        return stat.count_in == 5 && stat.queue_in == 4;
+    }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(pipeline.get_statistics().count_in == 5);
+
+    blocker.release();
+    REQUIRE(receive(out, 10) == range(0, 10));
+    REQUIRE(pipeline.get_statistics().count_dropped == 0);
+}
+
+
+TEST_CASE("Pipeline - drop_newest overflow policy", "[pipeline]"){
+    using namespace TestPipeline;
+    Pipeline pipeline("test_drop_newest", pipeline_config("test_drop_newest", {{"capacity", 4}, {"overflow", "drop_newest"}}));
+    RQueue out = InternalQueue::get_queue("test_drop_newest_out").subscribe(0);
+    start(pipeline);
+
+    ExecutorBlocker blocker;
+    send("test_drop_newest", 0, 10);
+    REQUIRE(wait_until([& pipeline]{ return pipeline.get_statistics().count_dropped == 6; }));
+    REQUIRE(pipeline.get_statistics().queue_in == 4);
+
+    blocker.release();
+    REQUIRE(receive(out, 4) == range(0, 4));
+}
+
+
+TEST_CASE("Pipeline - drop_oldest overflow policy", "[pipeline]"){
+    using namespace TestPipeline;
+    Pipeline pipeline("test_drop_oldest", pipeline_config("test_drop_oldest", {{"capacity", 4}, {"overflow", "drop_oldest"}}));
+    RQueue out = InternalQueue::get_queue("test_drop_oldest_out").subscribe(0);
+    start(pipeline);
+
+    ExecutorBlocker blocker;
+    send("test_drop_oldest", 0, 10);
+    REQUIRE(wait_until([& pipeline]{ return pipeline.get_statistics().count_dropped == 6; }));
+    REQUIRE(pipeline.get_statistics().queue_in == 4);
+
+    blocker.release();
+    REQUIRE(receive(out, 4) == range(6, 10));
+}
+
+
+TEST_CASE("Pipeline - dlq overflow policy", "[pipeline]"){
+    using namespace TestPipeline;
+    Pipeline pipeline("test_dlq", pipeline_config("test_dlq", {{"capacity", 4}, {"overflow", "dlq"}, {"dlq", "test_dlq_dead"}}));
+    RQueue out = InternalQueue::get_queue("test_dlq_out").subscribe(0);
+    RQueue dead = InternalQueue::get_queue("test_dlq_dead").subscribe(0);
+    start(pipeline);
+
+    ExecutorBlocker blocker;
+    send("test_dlq", 0, 10);
+    REQUIRE(wait_until([& pipeline]{ return pipeline.get_statistics().count_dead_lettered == 6; }));
+    REQUIRE(pipeline.get_statistics().count_dropped == 0);
+
+    blocker.release();
+    REQUIRE(receive(out, 4) == range(0, 4));
+    REQUIRE(receive(dead, 6) == range(4, 10));
+}
+
+
+TEST_CASE("Pipeline - full dead letter queue", "[pipeline]"){
+    using namespace TestPipeline;
+    Pipeline pipeline("test_dlq_full", pipeline_config("test_dlq_full", {{"capacity", 4}, {"overflow", "dlq"}, {"dlq", "test_dlq_full_dead"}}));
+    RQueue out = InternalQueue::get_queue("test_dlq_full_out").subscribe(0);
+    RQueue dead = InternalQueue::get_queue("test_dlq_full_dead").subscribe(2);
+    start(pipeline);
+
+    {
+        ExecutorBlocker blocker;
+        send("test_dlq_full", 0, 10);
+        // Messages which do not fit into the dead letter queue are dropped
+        REQUIRE(wait_until([& pipeline]{
+            auto stat = pipeline.get_statistics();
+            return stat.count_dead_lettered == 2 && stat.count_dropped == 4;
+        }));
+    }
+    REQUIRE(receive(out, 4) == range(0, 4));
+    REQUIRE(receive(dead, 2) == range(4, 6));
+
+    // The pipeline keeps receiving
+    send("test_dlq_full", 10, 11);
+    REQUIRE(receive(out, 1) == range(10, 11));
+    REQUIRE(pipeline.get_state() == PipelineState::RUNNING);
+    REQUIRE(pipeline.get_last_error().empty());
+}
+
+
+TEST_CASE("Pipeline - partitions by key", "[pipeline]"){
+    json config = TestPipeline::pipeline_config("test_partition", json::object());
+    config["workers"] = 4;
+    config["partition_key"] = "{{MSG.PAYLOAD.key}}";
+    Pipeline pipeline("test_partition", config);
+
+    auto message = [](std::string const & payload){
+        return Message(payload, MessageFormat::Type::JSON);
+    };
+    // Messages without the key go to the first worker
+    REQUIRE(pipeline.partition(message(R"({"seq": 1})")) == 0);
+    REQUIRE(pipeline.partition(message(R"({"seq": 2})")) == 0);
+    REQUIRE(pipeline.partition(Message(std::string("raw"), MessageFormat::Type::RAW)) == 0);
+
+    // The key alone picks the worker
+    size_t ix = pipeline.partition(message(R"({"key": "a", "seq": 1})"));
+    REQUIRE(pipeline.partition(message(R"({"seq": 2, "key": "a"})")) == ix);
+
+    std::set<size_t> used;
+    for(int k = 0; k < 32; ++k){
+        size_t ix = pipeline.partition(message(R"({"key": "k)" + std::to_string(k) + R"("})"));
+        REQUIRE(ix < 4);
+        used.insert(ix);
+    }
+    REQUIRE(used.size() > 1);
+}
+
+
+TEST_CASE("Pipeline - messages with the same key keep their order", "[pipeline]"){
+    using namespace TestPipeline;
+    json config = pipeline_config("test_partition_order", json::object());
+    config["connector_in"]["buffer_size"] = 0;  // unbounded
+    config["workers"] = 4;
+    config["partition_key"] = "{{MSG.PAYLOAD.key}}";
+    Pipeline pipeline("test_partition_order", config);
+    RQueue out = InternalQueue::get_queue("test_partition_order_out").subscribe(0);
+    start(pipeline);
+
+    std::vector<std::string> keys {"a", "b", "c", "d", "e", "f", "g", "h"};
+    constexpr int COUNT = 200;
+    auto & in = InternalQueue::get_queue("test_partition_order_in");
+    for(int seq = 0; seq < COUNT; ++seq){
+        for(auto const & key : keys){
+            in.push(Message(json{{"key", key}, {"seq", seq}}.dump(), MessageFormat::Type::JSON));
+        }
+        in.push(Message(json{{"seq", seq}}.dump(), MessageFormat::Type::JSON));
+    }
+
+    std::map<std::string, std::vector<int>> received;
+    for(auto const & raw : receive(out, COUNT * (keys.size() + 1))){
+        json j = json::parse(raw);
+        received[j.value("key", "")].push_back(j["seq"].get<int>());
+    }
+    std::vector<int> expected(COUNT);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(received.size() == keys.size() + 1);
+    for(auto const & [key, seqs] : received){
+        INFO("key: " << key);
+        REQUIRE(seqs == expected);
+    }
+}
+
+#endif
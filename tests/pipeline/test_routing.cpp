@@ -0,0 +1,51 @@
+#ifndef TEST_ROUTING_GRAPH_H
+#define TEST_ROUTING_GRAPH_H
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/pipeline.h"
+
+
+TEST_CASE("RoutingGraph - resolves goto", "[routing_graph]"){
+    json filtras = {
+        {{"name", "check"}, {"goto_passed", "on"}, {"goto_rejected", "off"}},
+        {{"name", "on"}, {"goto", "out"}, {"queues", {"audit"}}},
+        {{"name", "off"}},
+    };
+    auto graph = RoutingGraph::from_json(filtras);
+
+    REQUIRE(graph.size() == 3);
+    REQUIRE(graph[0].passed == 1);
+    REQUIRE(graph[0].rejected == 2);
+    REQUIRE(graph[1].passed == 3);
+    REQUIRE(graph[1].rejected == 3);
+    REQUIRE(graph[1].queue_ids == std::vector<string>{"audit"});
+    REQUIRE(graph[2].passed == 3);
+    REQUIRE(graph[2].rejected == FiltraRoute::DROP);
+
+    graph.bind_queues();
+    REQUIRE(graph[1].queues.front() == InternalQueue::get_queue_ptr("audit"));
+}
+
+
+TEST_CASE("RoutingGraph - invalid goto", "[routing_graph]"){
+    json unknown = {
+        {{"name", "a"}, {"goto", "b"}}
+    };
+    REQUIRE_THROWS_AS(RoutingGraph::from_json(unknown), configuration_error);
+
+    json self_loop = {
+        {{"name", "a"}},
+        {{"name", "b"}, {"goto", "b"}}
+    };
+    REQUIRE_THROWS_AS(RoutingGraph::from_json(self_loop), configuration_error);
+
+    // A loop is fine as long as rejected messages can leave it
+    json loop = {
+        {{"name", "a"}},
+        {{"name", "b"}, {"goto_passed", "a"}}
+    };
+    REQUIRE_NOTHROW(RoutingGraph::from_json(loop));
+}
+
+#endif
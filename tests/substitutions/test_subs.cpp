@@ -0,0 +1,148 @@
+#ifndef TEST_SUBS_H
+#define TEST_SUBS_H
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+#ifdef WITH_IMAGE_HANDLERS
+    #include <opencv2/opencv.hpp>
+#endif
+
+#include "../src/substitutions/subs.hpp"
+
+
+static std::span<std::byte const> as_bytes(std::string const & s){
+    return {reinterpret_cast<std::byte const *>(s.data()), s.size()};
+}
+
+static std::string as_string(substituted_t const & v){
+    if( std::holds_alternative<std::vector<unsigned char>>(v) ){
+        auto const & d = std::get<std::vector<unsigned char>>(v);
+        return std::string(d.begin(), d.end());
+    }
+    auto d = std::get<std::span<std::byte const>>(v);
+    return std::string(reinterpret_cast<char const *>(d.data()), d.size());
+}
+
+
+TEST_CASE("ModifierMemo - results are reused by content", "[subs]"){
+    ModifierMemo memo;
+    int calls = 0;
+    auto reverse = [& calls](std::span<std::byte const> input){
+        ++calls;
+        auto p = reinterpret_cast<unsigned char const *>(input.data());
+        return std::vector<unsigned char>(std::make_reverse_iterator(p + input.size()),
+                                          std::make_reverse_iterator(p));
+    };
+    int modifier_a = 0, modifier_b = 0;
+
+    std::string first = "abc";
+    std::string same = "abc";
+    auto r1 = memo.apply(& modifier_a, as_bytes(first), reverse);
+    REQUIRE(as_string(r1) == "cba");
+    // Equal bytes at another address hit the memo, the kept result is not copied
+    auto r2 = memo.apply(& modifier_a, as_bytes(same), reverse);
+    REQUIRE(std::get<std::span<std::byte const>>(r2).data() == std::get<std::span<std::byte const>>(r1).data());
+    REQUIRE(calls == 1);
+
+    // Another modifier or other bytes run again
+    memo.apply(& modifier_b, as_bytes(first), reverse);
+    memo.apply(& modifier_a, as_bytes(std::string("abd")), reverse);
+    REQUIRE(calls == 3);
+    REQUIRE(memo.size() == 3);
+
+    memo.clear();
+    memo.apply(& modifier_a, as_bytes(first), reverse);
+    REQUIRE(calls == 4);
+}
+
+
+TEST_CASE("ModifierMemo - byte budget", "[subs]"){
+    ModifierMemo memo(8);
+    int calls = 0;
+    auto copy = [& calls](std::span<std::byte const> input){
+        ++calls;
+        auto p = reinterpret_cast<unsigned char const *>(input.data());
+        return std::vector<unsigned char>(p, p + input.size());
+    };
+    int modifier = 0;
+
+    std::string big = "too large";
+    REQUIRE(as_string(memo.apply(& modifier, as_bytes(big), copy)) == big);
+    memo.apply(& modifier, as_bytes(big), copy);
+    REQUIRE(calls == 2);
+    REQUIRE(memo.size() == 0);
+
+    // Input and result count against the budget
+    std::string small = "okay";
+    memo.apply(& modifier, as_bytes(small), copy);
+    memo.apply(& modifier, as_bytes(small), copy);
+    REQUIRE(calls == 3);
+    REQUIRE(memo.size() == 1);
+}
+
+TEST_CASE("ModifierMemo - inputs of the same size", "[subs]"){
+    ModifierMemo memo;
+    int calls = 0;
+    auto copy = [& calls](std::span<std::byte const> input){
+        ++calls;
+        auto p = reinterpret_cast<unsigned char const *>(input.data());
+        return std::vector<unsigned char>(p, p + input.size());
+    };
+    int modifier = 0;
+
+    // Same size, differing only in the last byte
+    std::string a(4096, 'x'), b(4096, 'x');
+    b.back() = 'y';
+    REQUIRE(as_string(memo.apply(& modifier, as_bytes(a), copy)) == a);
+    REQUIRE(as_string(memo.apply(& modifier, as_bytes(b), copy)) == b);
+    REQUIRE(calls == 2);
+}
+
+
+
+TEST_CASE("CompiledTemplate - modifiers are resolved when compiled", "[subs]"){
+    REQUIRE_THROWS_AS(CompiledTemplate("{{EXTRA.image|shrink,10}}"), configuration_error);
+    REQUIRE_NOTHROW(CompiledTemplate("{{EXTRA.image}}"));
+}
+
+
+TEST_CASE("CompiledTemplate - modifier parameters", "[subs]"){
+#ifdef WITH_IMAGE_HANDLERS
+    REQUIRE_NOTHROW(CompiledTemplate("{{EXTRA.image|resize,320}}"));
+    REQUIRE_NOTHROW(CompiledTemplate("{{EXTRA.image|resize,320,240}}"));
+#else
+    // Parsed, then refused as image modifiers are not built
+    REQUIRE_THROWS_WITH(CompiledTemplate("{{EXTRA.image|resize,320,240}}"),
+                        Catch::Matchers::Contains("Unsupported modifier: resize,320,240"));
+#endif
+}
+
+
+#ifdef WITH_IMAGE_HANDLERS
+
+TEST_CASE("SubsEngine - resize modifier with width and height", "[subs]"){
+    cv::Mat image(480, 640, CV_8UC3, cv::Scalar(40, 120, 200));
+    std::vector<uchar> jpeg;
+    REQUIRE(cv::imencode(".jpeg", image, jpeg));
+    MessageWrapper msg_w(std::make_shared<Message>(std::string("{}"), MessageFormat::Type::JSON, "t/1"));
+    msg_w.get_extra().add_extra("image", uchars(jpeg.begin(), jpeg.end()));
+
+    auto se = SubsEngine(msg_w);
+    for(auto [atemplate, width, height] : {std::tuple{"{{EXTRA.image|resize,320}}", 320, 240},
+                                          std::tuple{"{{EXTRA.image|resize,320,100}}", 320, 100}}){
+        std::string resized = as_string(se.substitute(CompiledTemplate(atemplate)));
+        cv::Mat input(1, static_cast<int>(resized.size()), CV_8UC1, resized.data());
+        cv::Mat decoded = cv::imdecode(input, cv::IMREAD_COLOR);
+        REQUIRE(decoded.size() == cv::Size(width, height));
+    }
+}
+
+#endif  // WITH_IMAGE_HANDLERS
+
+#endif  // TEST_SUBS_H
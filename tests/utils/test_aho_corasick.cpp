@@ -0,0 +1,30 @@
+#ifndef TEST_AHO_CORASICK_H
+#define TEST_AHO_CORASICK_H
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/utils/aho_corasick.h"
+
+
+TEST_CASE("AhoCorasick - first match", "[aho_corasick]"){
+    AhoCorasick ac({"he", "she", "his", "hers"});
+
+    REQUIRE(ac.find_first("ushers") == 1);  // "she" and "he" end together, the longer is reported
+    REQUIRE(ac.find_first("this") == 2);
+    REQUIRE(ac.find_first("hhhe") == 0);
+    REQUIRE(ac.find_first("nothing") == AhoCorasick::NO_MATCH);
+    REQUIRE(ac.find_first("") == AhoCorasick::NO_MATCH);
+
+    // A pattern found through a failure link
+    AhoCorasick nested({"abcd", "bc"});
+    REQUIRE(nested.find_first("xabcx") == 1);
+
+    AhoCorasick folded({"Warn", "ERR"}, true);
+    REQUIRE(folded.find_first("..err..") == 1);
+    REQUIRE(folded.find_first("wARN") == 0);
+    REQUIRE(AhoCorasick({"Warn"}).find_first("warn") == AhoCorasick::NO_MATCH);
+
+    REQUIRE_THROWS_AS(AhoCorasick({}), std::invalid_argument);
+}
+
+#endif
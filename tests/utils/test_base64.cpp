@@ -0,0 +1,50 @@
+#ifndef TEST_BASE64_H
+#define TEST_BASE64_H
+
+#include <string>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/utils/base64.h"
+
+
+TEST_CASE("base64 - encode", "[base64]"){
+    // RFC 4648 test vectors
+    REQUIRE(base64_encode("") == "");
+    REQUIRE(base64_encode("f") == "Zg==");
+    REQUIRE(base64_encode("fo") == "Zm8=");
+    REQUIRE(base64_encode("foo") == "Zm9v");
+    REQUIRE(base64_encode("foob") == "Zm9vYg==");
+    REQUIRE(base64_encode("fooba") == "Zm9vYmE=");
+    REQUIRE(base64_encode("foobar") == "Zm9vYmFy");
+
+    // Long enough for the block path, with every byte value and every tail length
+    std::string input;
+    for(int i = 0; i < 300; ++i){
+        input.push_back(static_cast<char>(i * 37 + 11));
+    }
+    for(size_t len = 0; len < input.size(); ++len){
+        std::string expected;
+        int val = 0, bits = -6;
+        for(size_t i = 0; i < len; ++i){
+            val = (val << 8) + static_cast<unsigned char>(input[i]);
+            bits += 8;
+            while(bits >= 0){
+                expected.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(val >> bits) & 0x3F]);
+                bits -= 6;
+            }
+        }
+        if(bits > -6) expected.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[((val << 8) >> (bits + 8)) & 0x3F]);
+        while(expected.size() % 4) expected.push_back('=');
+
+        INFO("length " << len);
+        REQUIRE(base64_encode(std::string_view(input.data(), len)) == expected);
+    }
+
+    std::string out = "x";
+    std::vector<std::byte> bytes {std::byte{0xFB}, std::byte{0xFF}};
+    base64_append(bytes, out);
+    REQUIRE(out == "x+/8=");
+}
+
+#endif
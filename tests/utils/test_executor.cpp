@@ -0,0 +1,173 @@
+#ifndef TEST_EXECUTOR_H
+#define TEST_EXECUTOR_H
+
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <thread>
+
+#include "../src/utils/executor.h"
+#include "../src/utils/blocking_pool.h"
+
+
+TEST_CASE("WorkStealingDeque - owner and thieves", "[executor]"){
+    WorkStealingDeque<long *> deque(4);
+    constexpr long count = 100000;
+    std::vector<long> values(count);
+    std::atomic<long> taken {0};
+    std::atomic<bool> done {false};
+
+    auto thief = [&]{
+        while(! done || ! deque.empty()){
+            if(long * v = deque.steal()){
+                ++ * v;
+                ++taken;
+            }
+        }
+    };
+    std::thread t1(thief), t2(thief);
+
+    for(long i = 0; i < count; ++i){
+        deque.push(& values[i]);
+        if(i % 3 == 0){
+            if(long * v = deque.pop()){
+                ++ * v;
+                ++taken;
+            }
+        }
+    }
+    while(long * v = deque.pop()){
+        ++ * v;
+        ++taken;
+    }
+    done = true;
+    t1.join();
+    t2.join();
+
+    REQUIRE(taken == count);
+    REQUIRE(std::all_of(values.begin(), values.end(), [](long v){ return v == 1; }));
+}
+
+
+TEST_CASE("Executor - runs submitted and nested tasks", "[executor]"){
+    Executor executor(4);
+    std::atomic<int> counter {0};
+
+    for(int i = 0; i < 1000; ++i){
+        executor.submit([&]{
+            executor.submit([&]{ ++counter; });
+            ++counter;
+        });
+    }
+
+    for(int i = 0; i < 500 && counter < 2000; ++i){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(counter == 2000);
+}
+
+
+TEST_CASE("SerialTask - never runs concurrently and loses no wake-ups", "[executor]"){
+    Executor executor(4);
+    std::atomic<int> running {0};
+    std::atomic<bool> overlapped {false};
+    std::atomic<long> produced {0};
+    long consumed = 0;
+
+    SerialTask task(executor, [&]{
+        if(running.fetch_add(1) != 0) overlapped = true;
+        consumed = produced.load();
+        running.fetch_sub(1);
+    });
+
+    std::vector<std::thread> producers;
+    for(int t = 0; t < 4; ++t){
+        producers.emplace_back([&]{
+            for(int i = 0; i < 10000; ++i){
+                ++produced;
+                task.schedule();
+            }
+        });
+    }
+    for(auto & p : producers) p.join();
+    task.wait_idle();
+
+    REQUIRE_FALSE(overlapped);
+    REQUIRE(consumed == 40000);
+}
+
+
+// Submitted once a busy task holds the only worker, the task must still run
+static bool runs_next_to(Executor & executor){
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::atomic<bool> ran {false};
+    executor.submit([&]{ ran = true; });
+    for(int i = 0; i < 100 && ! ran; ++i){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return ran;
+}
+
+
+TEST_CASE("Executor - rescheduled serial task does not starve the others", "[executor]"){
+    Executor executor(1);
+    std::atomic<bool> stop {false};
+    std::atomic<long> runs {0};
+
+    SerialTask hot(executor, [&]{
+        ++runs;
+        if(! stop) hot.schedule();
+    });
+    hot.schedule();
+
+    bool ran = runs_next_to(executor);
+    stop = true;
+    hot.wait_idle();
+
+    REQUIRE(ran);
+    REQUIRE(runs > 0);
+}
+
+
+TEST_CASE("Executor - nested submits do not starve the others", "[executor]"){
+    std::atomic<bool> stop {false};
+    std::atomic<long> runs {0};
+    bool ran = false;
+    {
+        Executor executor(1);
+        // Goes to the worker's own deque every time
+        std::function<void()> chain = [&]{
+            ++runs;
+            if(! stop) executor.submit(chain);
+        };
+        executor.submit(chain);
+
+        ran = runs_next_to(executor);
+        stop = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    REQUIRE(ran);
+    REQUIRE(runs > 0);
+}
+
+
+TEST_CASE("BlockingPool - runs blocking tasks in parallel", "[executor]"){
+    BlockingPool pool;
+    std::atomic<int> arrived {0};
+
+    for(int i = 0; i < 8; ++i){
+        pool.submit([&]{
+            ++arrived;
+            // Would never finish if the tasks ran one after another
+            while(arrived < 8) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    }
+
+    for(int i = 0; i < 500 && arrived < 8; ++i){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(arrived == 8);
+    REQUIRE(pool.size() >= 8);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TEST_IMAGE_SIZE_H
+#define TEST_IMAGE_SIZE_H
+
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/utils/image_size.h"
+
+
+TEST_CASE("ImageSize - probe", "[image_size]"){
+    // SOI, an APP0 segment, a fill byte, then a baseline frame of 4000x3000
+    std::vector<unsigned char> jpeg {
+        0xFF, 0xD8,
+        0xFF, 0xE0, 0x00, 0x06, 'J', 'F', 'I', 'F',
+        0xFF,
+        0xFF, 0xC0, 0x00, 0x11, 0x08, 0x0B, 0xB8, 0x0F, 0xA0, 0x03
+    };
+    auto size = ImageSize::probe(jpeg);
+    REQUIRE(size);
+    REQUIRE(size->format == ImageSize::Format::JPEG);
+    REQUIRE(size->width == 4000);
+    REQUIRE(size->height == 3000);
+
+    // A Huffman table segment is not a frame
+    std::vector<unsigned char> no_frame {0xFF, 0xD8, 0xFF, 0xC4, 0x00, 0x03, 0x00, 0xFF, 0xDA, 0x00, 0x02};
+    REQUIRE_FALSE(ImageSize::probe(no_frame));
+
+    std::vector<unsigned char> png {
+        0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A,
+        0x00, 0x00, 0x00, 0x0D, 'I', 'H', 'D', 'R',
+        0x00, 0x00, 0x02, 0x80, 0x00, 0x00, 0x01, 0xE0
+    };
+    size = ImageSize::probe(png);
+    REQUIRE(size);
+    REQUIRE(size->format == ImageSize::Format::PNG);
+    REQUIRE(size->width == 640);
+    REQUIRE(size->height == 480);
+
+    std::vector<unsigned char> text {'h', 'e', 'l', 'l', 'o'};
+    REQUIRE_FALSE(ImageSize::probe(text));
+    REQUIRE_FALSE(ImageSize::probe(std::vector<unsigned char>(jpeg.begin(), jpeg.begin() + 12)));
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef TEST_LUA_BRIDGE_H
+#define TEST_LUA_BRIDGE_H
+
+#ifdef WITH_LUA
+
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/utils/lua_bridge.h"
+
+
+namespace
+{
+    struct LuaState{
+        lua_State * L;
+
+        explicit LuaState(char const * code): L(luaL_newstate()){
+            luaL_openlibs(L);
+            lua_bridge::register_payload_view(L);
+            REQUIRE(luaL_dostring(L, code) == 0);
+        }
+        ~LuaState(){ lua_close(L); }
+
+        // Calls the global function with the value on top of the stack
+        void call(char const * name){
+            lua_getglobal(L, name);
+            lua_insert(L, -2);
+            if(lua_pcall(L, 1, 1, 0)) FAIL(lua_tostring(L, -1));
+        }
+    };
+}
+
+
+TEST_CASE("Lua bridge - JSON tables", "[lua_bridge]"){
+    LuaState lua("function convert(t) t.n = t.n + 1; return t end");
+
+    json input = {{"n", 41}, {"list", {1, 2.5, "x", true}}, {"empty", json::object()}, {"nested", {{"a", "b"}}}};
+    lua_bridge::push_json(lua.L, input);
+    lua.call("convert");
+
+    json expected = input;
+    expected["n"] = 42;
+    REQUIRE(lua_bridge::to_json(lua.L, -1) == expected);
+}
+
+
+TEST_CASE("Lua bridge - payload view", "[lua_bridge]"){
+    LuaState lua(R"(
+        kept = nil
+        function convert(v)
+            kept = v
+            local s, e = v:find("temp")
+            return #v .. ":" .. v:sub(s, e) .. ":" .. v:byte(1) .. ":" .. tostring(v):sub(-3)
+        end
+        function later() return #kept end
+    )");
+
+    std::string payload = "{\"temp\": 21}";
+    auto view = lua_bridge::push_payload_view(lua.L, payload);
+    lua.call("convert");
+    lua_bridge::invalidate(view);
+    REQUIRE(std::string(lua_tostring(lua.L, -1)) == "12:temp:123:21}");
+
+    // A view kept by the script can not be read after the call
+    lua_getglobal(lua.L, "later");
+    REQUIRE(lua_pcall(lua.L, 0, 1, 0) != 0);
+}
+
+
+TEST_CASE("Lua bridge - batch benchmark", "[.][benchmark][lua_bridge]"){
+    LuaState lua(R"(
+        function convert(p) return p:upper() end
+        function convert_batch(ps)
+            local out = {}
+            for i = 1, #ps do out[i] = ps[i]:upper() end
+            return out
+        end
+    )");
+    std::vector<std::string> payloads(64, "{\"temp\": 21.5, \"unit\": \"C\"}");
+
+    BENCHMARK("convert, 64 calls"){
+        size_t total = 0;
+        for(auto const & p : payloads){
+            lua_getglobal(lua.L, "convert");
+            lua_pushlstring(lua.L, p.data(), p.size());
+            lua_pcall(lua.L, 1, 1, 0);
+            size_t len;
+            lua_tolstring(lua.L, -1, & len);
+            total += len;
+            lua_pop(lua.L, 1);
+        }
+        return total;
+    };
+
+    BENCHMARK("convert_batch, 1 call of 64"){
+        size_t total = 0;
+        lua_getglobal(lua.L, "convert_batch");
+        lua_createtable(lua.L, static_cast<int>(payloads.size()), 0);
+        for(size_t i = 0; i < payloads.size(); ++i){
+            lua_pushlstring(lua.L, payloads[i].data(), payloads[i].size());
+            lua_rawseti(lua.L, -2, static_cast<lua_Integer>(i + 1));
+        }
+        lua_pcall(lua.L, 1, 1, 0);
+        for(size_t i = 0; i < payloads.size(); ++i){
+            lua_rawgeti(lua.L, -1, static_cast<lua_Integer>(i + 1));
+            size_t len;
+            lua_tolstring(lua.L, -1, & len);
+            total += len;
+            lua_pop(lua.L, 1);
+        }
+        lua_pop(lua.L, 1);
+        return total;
+    };
+}
+
+#endif  // WITH_LUA
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef TEST_REGEX_DFA_H
+#define TEST_REGEX_DFA_H
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_all.hpp>
+
+#include "../src/utils/regex_dfa.h"
+
+
+TEST_CASE("DfaRegex - search", "[regex_dfa]"){
+    REQUIRE(DfaRegex("abc").search("xxabcxx"));
+    REQUIRE_FALSE(DfaRegex("abc").search("ab"));
+    REQUIRE(DfaRegex("").search(""));
+
+    REQUIRE(DfaRegex("^abc").search("abcd"));
+    REQUIRE_FALSE(DfaRegex("^abc").search("xabc"));
+    REQUIRE(DfaRegex("abc$").search("xabc"));
+    REQUIRE_FALSE(DfaRegex("abc$").search("abcx"));
+    REQUIRE(DfaRegex("^$").search(""));
+    REQUIRE_FALSE(DfaRegex("^$").search("a"));
+
+    REQUIRE(DfaRegex("a(b|cd)+e").search("abcdbe"));
+    REQUIRE_FALSE(DfaRegex("a(b|cd)+e").search("ae"));
+    REQUIRE(DfaRegex("^\\d{3}-\\d{2,}$").search("123-4567"));
+    REQUIRE_FALSE(DfaRegex("^\\d{3}-\\d{2,}$").search("123-4"));
+    REQUIRE(DfaRegex("^[a-c]{1,2}$").search("cb"));
+    REQUIRE_FALSE(DfaRegex("^[a-c]{1,2}$").search("abc"));
+    REQUIRE(DfaRegex("[^0-9]").search("12x3"));
+    REQUIRE(DfaRegex("a{,2}").search("a{,2}"));  // not a counted repetition
+    REQUIRE(DfaRegex("\\.\\x41").search("x.A"));
+    REQUIRE_FALSE(DfaRegex("a.c").search("a\nc"));
+
+    REQUIRE(DfaRegex("error", true).search("An ERROR occured"));
+    REQUIRE_FALSE(DfaRegex("error").search("An ERROR occured"));
+
+    REQUIRE_THROWS_AS(DfaRegex("(ab"), std::invalid_argument);
+    REQUIRE_THROWS_AS(DfaRegex("ab)"), std::invalid_argument);
+    REQUIRE_THROWS_AS(DfaRegex("*a"), std::invalid_argument);
+    REQUIRE_THROWS_AS(DfaRegex("(a)\\1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(DfaRegex("(?=a)"), std::invalid_argument);
+    REQUIRE_THROWS_AS(DfaRegex("a{3,1}"), std::invalid_argument);
+    REQUIRE_THROWS_AS(DfaRegex("(a{1000}){1000}"), std::invalid_argument);
+}
+
+
+TEST_CASE("DfaRegex - agrees with std::regex", "[regex_dfa]"){
+    std::vector<std::string> patterns {
+        "a*b", "(a|b)*abb", "^(ab)+$", "x?y?z?$", "[ab]{2,3}c", "^a.*b$",
+        "(a|ab)(c|bcd)", "\\w+@\\w+", "\\s\\S", "^(a*)*b", "b{2}|a{3,}"
+    };
+    std::vector<std::string> texts {
+        "", "a", "b", "ab", "abb", "aabb", "ababab", "xyz", "yz", "aabc",
+        "babac", "abcd", "me@host", "a b", "bb", "aaa", "aaaa", "cab", "ba"
+    };
+    for(auto const & pattern : patterns){
+        DfaRegex re(pattern);
+        std::regex std_re(pattern);
+        for(auto const & text : texts){
+            INFO(pattern << " on \"" << text << "\"");
+            REQUIRE(re.search(text) == std::regex_search(text, std_re));
+        }
+    }
+}
+
+
+TEST_CASE("DfaRegex - case insensitive agrees with std::regex", "[regex_dfa]"){
+    std::vector<std::string> patterns {
+        "[^ab]c", "^[^A-C]+$", "^[^x]$", "[a-c]+D", "^[^\\d]", "[^\\W]", "\\W", "^[^_e]rr"
+    };
+    std::vector<std::string> texts {
+        "", "ABC", "abc", "xC", "Xc", "X", "x", "aBd", "def", "DEF", "1", "_", "Err", "err", "!"
+    };
+    for(auto const & pattern : patterns){
+        DfaRegex re(pattern, true);
+        std::regex std_re(pattern, std::regex::icase);
+        for(auto const & text : texts){
+            INFO(pattern << " on \"" << text << "\"");
+            REQUIRE(re.search(text) == std::regex_search(text, std_re));
+        }
+    }
+    REQUIRE_FALSE(DfaRegex("[^ab]c", true).search("ABC"));
+}
+
+
+TEST_CASE("DfaRegex - bounded cache", "[regex_dfa]"){
+    // The n-th byte from the end is 'a': 2^n DFA states if kept
+    DfaRegex re("a[ab]{12}$", false, 16 * 1024);
+    std::string text;
+    for(int i = 0; i < 4096; ++i){
+        text.push_back((i * 7919 % 13) & 1 ? 'a' : 'b');
+    }
+    std::regex std_re("a[ab]{12}$");
+    for(size_t len = 13; len < text.size(); len += 97){
+        std::string_view view(text.data(), len);
+        REQUIRE(re.search(view) == std::regex_search(view.begin(), view.end(), std_re));
+        REQUIRE(re.cached_states() < 16 * 1024 / 64);
+    }
+}
+
+
+TEST_CASE("DfaRegex - benchmark", "[.][benchmark][regex_dfa]"){
+    std::string payload;
+    for(int i = 0; i < 200; ++i){
+        payload += "{\"sensor\": \"temp/" + std::to_string(i) + "\", \"status\": \"ok\"} ";
+    }
+    payload += "{\"sensor\": \"temp/200\", \"status\": \"FATAL\"}";
+    std::string pattern = "temp/[0-9]+\", \"status\": \"(ERROR|FATAL)";
+
+    DfaRegex re(pattern);
+    std::regex std_re(pattern);
+    REQUIRE(re.search(payload));
+    REQUIRE(std::regex_search(payload, std_re));
+
+    BENCHMARK("DfaRegex"){
+        return re.search(payload);
+    };
+    BENCHMARK("std::regex"){
+        return std::regex_search(payload, std_re);
+    };
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef TEST_SPSC_QUEUE_H
+#define TEST_SPSC_QUEUE_H
+
+#include <catch2/catch_all.hpp>
+#include <thread>
+#include <memory>
+
+#include "../src/utils/spsc_queue.h"
+
+
+TEST_CASE("SPSCQueue - single thread", "[spsc_queue]"){
+    SPSCQueue<std::unique_ptr<int>> queue(3, false);
+
+    REQUIRE(queue.capacity() == 4);
+    REQUIRE(queue.empty());
+
+    for(int i = 0; i < 4; ++i){
+        REQUIRE(queue.try_push(std::make_unique<int>(i)));
+    }
+    REQUIRE_FALSE(queue.try_push(std::make_unique<int>(4)));
+    REQUIRE_THROWS_AS(queue.push(std::make_unique<int>(4)), std::overflow_error);
+    REQUIRE(queue.size() == 4);
+
+    for(int i = 0; i < 4; ++i){
+        auto value = queue.pop();
+        REQUIRE(* value == i);
+    }
+    REQUIRE_FALSE(queue.try_pop());
+    REQUIRE_THROWS_AS(queue.pop(), std::underflow_error);
+}
+
+
+TEST_CASE("SPSCQueue - producer and consumer threads", "[spsc_queue]"){
+    SPSCQueue<std::shared_ptr<long>> queue(16);
+    constexpr long count = 200000;
+
+    std::thread producer([&queue]{
+        for(long i = 0; i < count; ++i){
+            queue.push(std::make_shared<long>(i));
+        }
+    });
+
+    bool ordered = true;
+    for(long i = 0; i < count; ++i){
+        auto value = queue.pop();
+        ordered &= (* value == i);
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(queue.empty());
+}
+
+
+TEST_CASE("SPSCQueue - wake up blocked consumer", "[spsc_queue]"){
+    SPSCQueue<int> queue(4);
+
+    std::thread consumer([&queue]{
+        try{
+            while(true) queue.pop();
+        }catch(std::underflow_error){}
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.set_non_blocking();
+    consumer.join();
+
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("SPSCQueue - byte capacity", "[spsc_queue]"){
+    SPSCQueue<int> queue(8, false, 100);
+
+    REQUIRE(queue.try_push(1, 60));
+    REQUIRE_FALSE(queue.try_push(2, 50));
+    REQUIRE(queue.try_push(3, 40));
+    REQUIRE(queue.bytes() == 100);
+
+    REQUIRE(queue.pop() == 1);
+    REQUIRE(queue.bytes() == 40);
+    REQUIRE(queue.pop() == 3);
+    REQUIRE(queue.bytes() == 0);
+
+    // Oversized element gets through an empty queue only
+    REQUIRE(queue.try_push(4, 500));
+    REQUIRE_FALSE(queue.try_push(5, 1));
+}
+
+
+TEST_CASE("SPSCQueue - evict oldest", "[spsc_queue]"){
+    SPSCQueue<int> queue(2, false);
+
+    REQUIRE(queue.try_push(1));
+    REQUIRE(queue.try_push(2));
+    REQUIRE_FALSE(queue.try_push(3));
+    REQUIRE(queue.evict() == 1);
+    REQUIRE(queue.try_push(3));
+    REQUIRE(queue.pop() == 2);
+    REQUIRE(queue.pop() == 3);
+    REQUIRE_FALSE(queue.evict());
+}
+
+
+TEST_CASE("SPSCQueue - evict while consumer pops", "[spsc_queue]"){
+    SPSCQueue<long> queue(8);
+    constexpr long count = 200000;
+    std::atomic<bool> done {false};
+    long evicted = 0;
+
+    std::thread producer([&]{
+        for(long i = 1; i <= count; ++i){
+            long value = i;
+            while(! queue.try_push(std::move(value))){
+                if(queue.evict()) ++evicted;
+            }
+        }
+        done = true;
+        queue.interrupt();
+    });
+
+    long consumed = 0;
+    long last = 0;
+    bool ordered = true;
+    while(! done || ! queue.empty()){
+        if(auto value = queue.try_pop()){
+            ordered &= (* value > last);
+            last = * value;
+            ++consumed;
+        }
+    }
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(consumed + evicted == count);
+}
+
+#endif
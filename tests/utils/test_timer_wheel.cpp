@@ -0,0 +1,97 @@
+#ifndef TEST_TIMER_WHEEL_H
+#define TEST_TIMER_WHEEL_H
+
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <thread>
+
+#include "../src/utils/timer_wheel.h"
+
+
+static void wait_for(std::function<bool()> done){
+    for(int i = 0; i < 500 && ! done(); ++i){
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+
+TEST_CASE("TimerWheel - order and delay", "[timer_wheel]"){
+    TimerWheel wheel;
+    std::atomic<int> order {0};
+    std::atomic<int> first {0}, second {0}, third {0};
+
+    auto start = std::chrono::steady_clock::now();
+    // 300 ms lands on the second level and is cascaded down before it fires
+    wheel.schedule(std::chrono::milliseconds(300), [&]{ third = ++order; });
+    wheel.schedule(std::chrono::milliseconds(60), [&]{ second = ++order; });
+    wheel.schedule(std::chrono::milliseconds(20), [&]{ first = ++order; });
+
+    wait_for([&]{ return third != 0; });
+
+    REQUIRE(first == 1);
+    REQUIRE(second == 2);
+    REQUIRE(third == 3);
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(300));
+    REQUIRE(wheel.size() == 0);
+}
+
+
+TEST_CASE("TimerWheel - cancel", "[timer_wheel]"){
+    TimerWheel wheel;
+    std::atomic<int> fired {0};
+
+    auto id = wheel.schedule(std::chrono::milliseconds(20), [&]{ ++fired; });
+    wheel.schedule(std::chrono::milliseconds(40), [&]{ ++fired; });
+    REQUIRE(wheel.cancel(id));
+    REQUIRE_FALSE(wheel.cancel(id));
+
+    wait_for([&]{ return fired != 0; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    REQUIRE(fired == 1);
+}
+
+
+TEST_CASE("TimerWheel - many timers", "[timer_wheel]"){
+    TimerWheel wheel;
+    constexpr int count = 100000;
+    std::atomic<int> fired {0};
+
+    for(int i = 0; i < count; ++i){
+        wheel.schedule(std::chrono::milliseconds(i % 700), [&]{ ++fired; });
+    }
+    wait_for([&]{ return fired == count; });
+    REQUIRE(fired == count);
+}
+
+
+TEST_CASE("TimerGroup - close", "[timer_wheel]"){
+    TimerWheel wheel;
+    TimerGroup group(wheel);
+    std::atomic<bool> running {false};
+    std::atomic<int> fired {0};
+
+    group.schedule(std::chrono::milliseconds(0), [&]{
+        running = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        running = false;
+        ++fired;
+    });
+    group.schedule(std::chrono::milliseconds(1000), [&]{ ++fired; });
+    REQUIRE(group.size() == 2);
+
+    wait_for([&]{ return running.load(); });
+    // Waits for the running callback, cancels the other one
+    group.close();
+    REQUIRE_FALSE(running);
+    REQUIRE(fired == 1);
+    REQUIRE(group.size() == 0);
+    REQUIRE(wheel.size() == 0);
+
+    REQUIRE(group.schedule(std::chrono::milliseconds(0), [&]{ ++fired; }) == TimerWheel::INVALID_TIMER);
+    group.open();
+    group.schedule(std::chrono::milliseconds(0), [&]{ ++fired; });
+    wait_for([&]{ return fired == 2; });
+    REQUIRE(fired == 2);
+}
+
+#endif